@@ -0,0 +1,101 @@
+#include "StiffOdeChartDecimator.hpp"
+
+#include <QtCharts/QValueAxis>
+#include <QtConcurrent/QtConcurrent>
+
+namespace StiffOde
+{
+QVector<QPointF> decimate(const DecimationTask& task)
+{
+    return decimateMinMax(task.count, task.pointAt, task.xMin, task.xMax, task.buckets);
+}
+
+QVector<QVector<QPointF>> decimateAll(const std::vector<DecimationTask>& tasks)
+{
+    return QtConcurrent::blockingMapped<QVector<QVector<QPointF>>>(tasks, decimate);
+}
+
+ChartDecimator::ChartDecimator(QChart* chart)
+    : QObject(chart),
+    m_chart(chart)
+{
+    connect(&m_watcher, &QFutureWatcher<QVector<QPointF>>::finished, this, &ChartDecimator::install);
+}
+
+ChartDecimator::~ChartDecimator()
+{
+    m_watcher.waitForFinished();
+}
+
+void ChartDecimator::addSeries(QLineSeries* series, size_t count, const PointFunction& pointAt)
+{
+    DecimationTask task;
+    task.count = count;
+    task.pointAt = pointAt;
+    addSeries(series, count, pointAt, decimate(task));
+}
+
+void ChartDecimator::addSeries(QLineSeries* series, size_t count, const PointFunction& pointAt,
+                               const QVector<QPointF>& points)
+{
+    m_sources.push_back({ series, count, pointAt });
+    series->replace(points);
+}
+
+void ChartDecimator::track()
+{
+    const auto axes = m_chart->axes(Qt::Horizontal);
+    auto* axisX = axes.isEmpty() ? nullptr : qobject_cast<QValueAxis*>(axes.first());
+    if (axisX == nullptr)
+        return;
+
+    m_xMin = axisX->min();
+    m_xMax = axisX->max();
+    m_buckets = bucketCount();
+
+    connect(axisX, &QValueAxis::rangeChanged, this, [this](qreal min, qreal max) {
+        m_xMin = min;
+        m_xMax = max;
+        update();
+    });
+    // Изменение высоты области построения не требует нового прореживания
+    connect(m_chart, &QChart::plotAreaChanged, this, [this]() {
+        if (bucketCount() != m_buckets)
+            update();
+    });
+}
+
+void ChartDecimator::update()
+{
+    if (m_watcher.isRunning()) {
+        m_updatePending = true;
+        return;
+    }
+
+    m_buckets = bucketCount();
+    std::vector<DecimationTask> tasks;
+    tasks.reserve(m_sources.size());
+    for (const Source& source : m_sources)
+        tasks.push_back({ source.count, source.pointAt, m_xMin, m_xMax, m_buckets });
+    m_watcher.setFuture(QtConcurrent::mapped(tasks, decimate));
+}
+
+void ChartDecimator::install()
+{
+    const QFuture<QVector<QPointF>> future = m_watcher.future();
+    for (size_t i = 0; i < m_sources.size() && static_cast<int>(i) < future.resultCount(); ++i)
+        m_sources[i].series->replace(future.resultAt(static_cast<int>(i)));
+
+    // Пока шёл пересчёт, диапазон или ширина изменились
+    if (m_updatePending) {
+        m_updatePending = false;
+        update();
+    }
+}
+
+int ChartDecimator::bucketCount() const
+{
+    const int width = static_cast<int>(m_chart->plotArea().width());
+    return width > 0 ? width : defaultBucketCount;
+}
+}
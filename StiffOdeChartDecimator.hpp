@@ -0,0 +1,170 @@
+#pragma once
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QPointF>
+#include <QVector>
+#include <QtCharts/QChart>
+#include <QtCharts/QLineSeries>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <vector>
+
+using namespace QtCharts;
+
+namespace StiffOde
+{
+// Прореживание упорядоченных по x точек: в каждом из buckets интервалов по x (по одному на пиксель) остаются
+// первая, последняя, минимальная и максимальная точки, поэтому изображение ломаной не меняется,
+// а узкие всплески (начальный жёсткий переходный процесс) не теряются.
+// Учитываются только точки в [xMin, xMax] и по одной соседней с каждой стороны, чтобы линия доходила до краёв.
+template <typename PointAt>
+QVector<QPointF> decimateMinMax(size_t count, const PointAt& pointAt, double xMin, double xMax, int buckets)
+{
+    QVector<QPointF> points;
+    if (count == 0 || buckets < 1)
+        return points;
+
+    // Первый индекс с x >= value
+    auto lowerBound = [&](double value) {
+        size_t low = 0;
+        size_t high = count;
+        while (low < high) {
+            const size_t middle = low + (high - low) / 2;
+            if (pointAt(middle).x() < value)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        return low;
+    };
+
+    size_t first = lowerBound(xMin);
+    size_t last = lowerBound(xMax);
+    if (first > 0)
+        --first;
+    last = std::min(last + 1, count);
+
+    const size_t visible = last - first;
+    if (visible <= 4 * static_cast<size_t>(buckets)) {
+        points.reserve(static_cast<int>(visible));
+        for (size_t i = first; i < last; ++i)
+            points.append(pointAt(i));
+        return points;
+    }
+
+    points.reserve(4 * buckets + 2);
+
+    // Точки хранятся вместе с индексами: pointAt() может считать значение заново (точное решение),
+    // поэтому в основном цикле он вызывается для каждого индекса один раз
+    struct IndexedPoint
+    {
+        size_t index;
+        QPointF point;
+    };
+
+    const QPointF firstPoint = pointAt(first);
+    const double x0 = firstPoint.x();
+    const double width = (pointAt(last - 1).x() - x0) / buckets;
+
+    IndexedPoint bucketFirst { first, firstPoint };
+    IndexedPoint bucketMin = bucketFirst;
+    IndexedPoint bucketMax = bucketFirst;
+    IndexedPoint previous = bucketFirst;
+    int bucket = 0;
+
+    auto flush = [&](const IndexedPoint& bucketLast) {
+        IndexedPoint selected[] = { bucketFirst, bucketMin, bucketMax, bucketLast };
+        std::sort(std::begin(selected), std::end(selected),
+                  [](const IndexedPoint& a, const IndexedPoint& b) { return a.index < b.index; });
+        for (size_t k = 0; k < 4; ++k) {
+            if (k == 0 || selected[k].index != selected[k - 1].index)
+                points.append(selected[k].point);
+        }
+    };
+
+    for (size_t i = first + 1; i < last; ++i) {
+        const IndexedPoint current { i, pointAt(i) };
+        const int pointBucket = width > 0.0
+                                ? std::min(static_cast<int>((current.point.x() - x0) / width), buckets - 1) : 0;
+        if (pointBucket != bucket) {
+            flush(previous);
+            bucket = pointBucket;
+            bucketFirst = bucketMin = bucketMax = previous = current;
+            continue;
+        }
+        if (current.point.y() < bucketMin.point.y())
+            bucketMin = current;
+        if (current.point.y() > bucketMax.point.y())
+            bucketMax = current;
+        previous = current;
+    }
+    flush(previous);
+
+    return points;
+}
+
+using PointFunction = std::function<QPointF(size_t)>;
+
+// Ширина в пикселях, пока график ещё не показан и область построения не известна
+constexpr int defaultBucketCount = 1024;
+
+// Прореживание одной серии; не обращается к объектам графика и может выполняться в любом потоке
+struct DecimationTask
+{
+    size_t count = 0;
+    PointFunction pointAt;
+    double xMin = std::numeric_limits<double>::lowest();
+    double xMax = std::numeric_limits<double>::max();
+    int buckets = defaultBucketCount;
+};
+
+QVector<QPointF> decimate(const DecimationTask& task);
+// Задачи выполняются параллельно в глобальном пуле потоков Qt; результаты - в порядке задач
+QVector<QVector<QPointF>> decimateAll(const std::vector<DecimationTask>& tasks);
+
+// Подставляет в серии графика прореженные данные под текущую ширину области построения
+// и видимый диапазон оси X; при масштабировании и изменении размера прореживание повторяется
+// в пуле потоков, а GUI-поток только заменяет точки серий готовыми буферами.
+class ChartDecimator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ChartDecimator(QChart* chart);
+    // Дожидается незавершённого прореживания: оно читает данные, которые удаляются после графика
+    ~ChartDecimator() override;
+
+    // Данные должны жить дольше графика; x не убывает с ростом индекса.
+    // Без points серия прореживается сразу в вызывающем потоке, points - уже прореженные по всему
+    // диапазону x данные (decimate() с DecimationTask по умолчанию), например подготовленные заранее
+    void addSeries(QLineSeries* series, size_t count, const PointFunction& pointAt);
+    void addSeries(QLineSeries* series, size_t count, const PointFunction& pointAt, const QVector<QPointF>& points);
+    // Подключает пересчёт к оси X; вызывается после создания осей графика
+    void track();
+
+private:
+    struct Source
+    {
+        QLineSeries* series;
+        size_t count;
+        PointFunction pointAt;
+    };
+
+    void update();
+    void install();
+    int bucketCount() const;
+
+    QChart* m_chart;
+    std::vector<Source> m_sources;
+    QFutureWatcher<QVector<QPointF>> m_watcher;
+    // Запросы, пришедшие во время прореживания, объединяются в один пересчёт по последнему диапазону
+    bool m_updatePending {false};
+    double m_xMin {0.0};
+    double m_xMax {0.0};
+    int m_buckets {0};
+};
+}
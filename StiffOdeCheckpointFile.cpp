@@ -0,0 +1,158 @@
+#include "StiffOdeCheckpointFile.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace StiffOde
+{
+namespace
+{
+const char fileMagic[4] = { 'S', 'O', 'C', 'P' };
+// Версия 2: число параметров чувствительности в байтах 60..63 и флаг их истории BDF в поле stiff
+const uint32_t fileVersion = 2;
+const uint32_t stiffFlag = 1;
+const uint32_t sensitivityHistoryFlag = 2;
+const size_t headerSize = 64;
+
+void encodeHeader(const SolverCheckpoint& checkpoint, unsigned char* bytes)
+{
+    const int32_t method = static_cast<int32_t>(checkpoint.method);
+    const int32_t order = checkpoint.order;
+    const uint32_t parameters = static_cast<uint32_t>(checkpoint.sensitivities.cols());
+    const uint32_t stiff = (checkpoint.stiff ? stiffFlag : 0)
+                           | (parameters > 0 && checkpoint.sensitivityHistory.size() > 0 ? sensitivityHistoryFlag : 0);
+    const uint64_t size = static_cast<uint64_t>(checkpoint.y.size());
+    const uint64_t historyColumns = static_cast<uint64_t>(checkpoint.history.cols());
+    const uint64_t equalSteps = checkpoint.equalSteps;
+
+    std::memset(bytes, 0, headerSize);
+    std::memcpy(bytes, fileMagic, 4);
+    std::memcpy(bytes + 4, &fileVersion, 4);
+    std::memcpy(bytes + 8, &method, 4);
+    std::memcpy(bytes + 12, &order, 4);
+    std::memcpy(bytes + 16, &size, 8);
+    std::memcpy(bytes + 24, &historyColumns, 8);
+    std::memcpy(bytes + 32, &equalSteps, 8);
+    std::memcpy(bytes + 40, &checkpoint.t, 8);
+    std::memcpy(bytes + 48, &checkpoint.h, 8);
+    std::memcpy(bytes + 56, &stiff, 4);
+    std::memcpy(bytes + 60, &parameters, 4);
+}
+
+bool decodeHeader(const unsigned char* bytes, SolverCheckpoint& checkpoint, uint64_t& size, uint64_t& historyColumns,
+                  uint32_t& parameters, bool& sensitivityHistory)
+{
+    uint32_t version = 0;
+    int32_t method = 0;
+    int32_t order = 0;
+    uint32_t stiff = 0;
+    uint64_t equalSteps = 0;
+
+    std::memcpy(&version, bytes + 4, 4);
+    if (std::memcmp(bytes, fileMagic, 4) != 0 || version < 1 || version > fileVersion)
+        return false;
+
+    std::memcpy(&method, bytes + 8, 4);
+    std::memcpy(&order, bytes + 12, 4);
+    std::memcpy(&size, bytes + 16, 8);
+    std::memcpy(&historyColumns, bytes + 24, 8);
+    std::memcpy(&equalSteps, bytes + 32, 8);
+    std::memcpy(&checkpoint.t, bytes + 40, 8);
+    std::memcpy(&checkpoint.h, bytes + 48, 8);
+    std::memcpy(&stiff, bytes + 56, 4);
+    // В версии 1 эти байты заполнены нулями
+    std::memcpy(&parameters, bytes + 60, 4);
+
+    checkpoint.method = static_cast<Method>(method);
+    checkpoint.order = order;
+    checkpoint.equalSteps = static_cast<size_t>(equalSteps);
+    checkpoint.stiff = (stiff & stiffFlag) != 0;
+    sensitivityHistory = parameters > 0 && (stiff & sensitivityHistoryFlag) != 0;
+    return size > 0;
+}
+}
+
+bool saveCheckpoint(const SolverCheckpoint& checkpoint, const std::string& path)
+{
+    const std::string temporaryPath = path + ".tmp";
+    std::FILE* file = std::fopen(temporaryPath.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+
+    unsigned char bytes[headerSize];
+    encodeHeader(checkpoint, bytes);
+
+    const size_t historySize = static_cast<size_t>(checkpoint.history.size());
+    const size_t sensitivitiesSize = static_cast<size_t>(checkpoint.sensitivities.size());
+    // История чувствительностей пишется, только если её форма соответствует истории y
+    const bool sensitivityHistory = sensitivitiesSize > 0 && checkpoint.sensitivityHistory.size() > 0;
+    const size_t sensitivityHistorySize = sensitivityHistory
+        ? sensitivitiesSize * static_cast<size_t>(checkpoint.history.cols()) : 0;
+    if (sensitivityHistory && static_cast<size_t>(checkpoint.sensitivityHistory.size()) != sensitivityHistorySize) {
+        std::fclose(file);
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+
+    bool failed = std::fwrite(bytes, 1, headerSize, file) != headerSize;
+    failed = failed || std::fwrite(checkpoint.y.data(), sizeof(double), static_cast<size_t>(checkpoint.y.size()), file)
+                           != static_cast<size_t>(checkpoint.y.size());
+    failed = failed || std::fwrite(checkpoint.history.data(), sizeof(double), historySize, file) != historySize;
+    failed = failed || std::fwrite(checkpoint.sensitivities.data(), sizeof(double), sensitivitiesSize, file)
+                           != sensitivitiesSize;
+    failed = failed || std::fwrite(checkpoint.sensitivityHistory.data(), sizeof(double), sensitivityHistorySize, file)
+                           != sensitivityHistorySize;
+    if (std::fclose(file) != 0)
+        failed = true;
+
+    if (!failed) {
+#ifdef _WIN32
+        std::remove(path.c_str());
+#endif
+        failed = std::rename(temporaryPath.c_str(), path.c_str()) != 0;
+    }
+    if (failed)
+        std::remove(temporaryPath.c_str());
+    return !failed;
+}
+
+bool loadCheckpoint(const std::string& path, SolverCheckpoint& checkpoint)
+{
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+        return false;
+
+    unsigned char bytes[headerSize];
+    SolverCheckpoint result;
+    uint64_t size = 0;
+    uint64_t historyColumns = 0;
+    uint32_t parameters = 0;
+    bool sensitivityHistory = false;
+    bool ok = std::fread(bytes, 1, headerSize, file) == headerSize
+              && decodeHeader(bytes, result, size, historyColumns, parameters, sensitivityHistory);
+
+    if (ok) {
+        const Eigen::Index n = static_cast<Eigen::Index>(size);
+        result.y.resize(n);
+        result.history.resize(historyColumns > 0 ? n : 0, static_cast<Eigen::Index>(historyColumns));
+        const size_t historySize = static_cast<size_t>(result.history.size());
+        ok = std::fread(result.y.data(), sizeof(double), static_cast<size_t>(n), file) == static_cast<size_t>(n)
+             && std::fread(result.history.data(), sizeof(double), historySize, file) == historySize;
+
+        const Eigen::Index p = static_cast<Eigen::Index>(parameters);
+        result.sensitivities.resize(p > 0 ? n : 0, p);
+        result.sensitivityHistory.resize(sensitivityHistory ? n * p : 0, sensitivityHistory ? result.history.cols() : 0);
+        const size_t sensitivitiesSize = static_cast<size_t>(result.sensitivities.size());
+        const size_t sensitivityHistorySize = static_cast<size_t>(result.sensitivityHistory.size());
+        ok = ok && std::fread(result.sensitivities.data(), sizeof(double), sensitivitiesSize, file) == sensitivitiesSize
+             && std::fread(result.sensitivityHistory.data(), sizeof(double), sensitivityHistorySize, file)
+                    == sensitivityHistorySize;
+    }
+    std::fclose(file);
+
+    if (ok)
+        checkpoint = std::move(result);
+    return ok;
+}
+}
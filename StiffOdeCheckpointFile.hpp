@@ -0,0 +1,14 @@
+#pragma once
+
+#include "StiffOdeSolver.hpp"
+
+#include <string>
+
+namespace StiffOde
+{
+// Двоичный формат контрольной точки: заголовок фиксированного размера, затем y и история BDF по столбцам,
+// чувствительности и их история, если они считаются, - всё из double в порядке байтов машины. Файл записывается во временный и переименовывается, поэтому
+// прерванная запись не портит предыдущую контрольную точку.
+bool saveCheckpoint(const SolverCheckpoint& checkpoint, const std::string& path);
+bool loadCheckpoint(const std::string& path, SolverCheckpoint& checkpoint);
+}
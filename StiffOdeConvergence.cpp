@@ -0,0 +1,255 @@
+#include "StiffOdeConvergence.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace StiffOde
+{
+namespace
+{
+// Соседние парные порядки установившегося участка отличаются не больше чем на эту долю
+const double pairOrderTolerance = 0.05;
+// Допустимое отклонение точек от прямой, в десятичных порядках погрешности
+const double fitResidualTolerance = 0.05;
+
+bool positive(double x, double y)
+{
+    return x > 0.0 && y > 0.0 && std::isfinite(y);
+}
+}
+
+double fitLogLogSlope(const std::vector<double>& x, const std::vector<double>& y, double* residual)
+{
+    double sumX = 0.0;
+    double sumY = 0.0;
+    double sumXX = 0.0;
+    double sumXY = 0.0;
+    size_t count = 0;
+
+    const size_t size = std::min(x.size(), y.size());
+    for (size_t i = 0; i < size; ++i) {
+        if (!positive(x[i], y[i]))
+            continue;
+        const double logX = std::log(x[i]);
+        const double logY = std::log(y[i]);
+        sumX += logX;
+        sumY += logY;
+        sumXX += logX * logX;
+        sumXY += logX * logY;
+        ++count;
+    }
+
+    if (residual != nullptr)
+        *residual = 0.0;
+    const double n = static_cast<double>(count);
+    const double denominator = n * sumXX - sumX * sumX;
+    if (count < 2 || denominator == 0.0)
+        return 0.0;
+    const double slope = (n * sumXY - sumX * sumY) / denominator;
+
+    if (residual != nullptr) {
+        const double intercept = (sumY - slope * sumX) / n;
+        double sumSquares = 0.0;
+        for (size_t i = 0; i < size; ++i) {
+            if (!positive(x[i], y[i]))
+                continue;
+            const double deviation = std::log(y[i]) - slope * std::log(x[i]) - intercept;
+            sumSquares += deviation * deviation;
+        }
+        *residual = std::sqrt(sumSquares / n) / std::log(10.0);
+    }
+    return slope;
+}
+
+std::vector<double> pairwiseLogLogSlopes(const std::vector<double>& x, const std::vector<double>& y)
+{
+    const size_t size = std::min(x.size(), y.size());
+    std::vector<double> slopes(size, std::numeric_limits<double>::quiet_NaN());
+    for (size_t i = 1; i < size; ++i) {
+        if (positive(x[i - 1], y[i - 1]) && positive(x[i], y[i]) && x[i] != x[i - 1])
+            slopes[i] = std::log(y[i] / y[i - 1]) / std::log(x[i] / x[i - 1]);
+    }
+    return slopes;
+}
+
+ConvergenceStudy::ConvergenceStudy(const StiffOdeSolver& solver, const ExactSolution& exactSolution)
+    : m_solver(solver), m_exactSolution(exactSolution)
+{
+    m_solver.setProgressCallback({});
+    m_solver.setOutputCallback({});
+    m_solver.setMethodSwitchCallback({});
+}
+
+void ConvergenceStudy::setParameter(StudyParameter parameter, double first, double ratio, size_t count)
+{
+    m_parameter = parameter;
+    m_first = first;
+    m_ratio = ratio;
+    m_count = count;
+}
+
+void ConvergenceStudy::setCancelFlag(const std::atomic<bool>* flag)
+{
+    m_cancelFlag = flag;
+}
+
+void ConvergenceStudy::setThreadCount(size_t count)
+{
+    m_threadCount = count;
+}
+
+void ConvergenceStudy::setProgressCallback(const ProgressCallback& callback)
+{
+    m_progress = callback;
+}
+
+ConvergenceStudyResult ConvergenceStudy::run(const std::vector<double>& initialConditions, double startTime,
+                                             double endTime) const
+{
+    ConvergenceStudyResult result;
+    if (!m_exactSolution || m_count == 0 || initialConditions.empty())
+        return result;
+
+    result.runs.resize(m_count);
+    for (size_t i = 0; i < m_count; ++i)
+        result.runs[i].parameter = m_first * std::pow(m_ratio, static_cast<double>(i));
+
+    const size_t hardwareThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    const size_t threads = std::min(m_threadCount > 0 ? m_threadCount : hardwareThreads, m_count);
+
+    // Прогоны раздаются с конца последовательности: при ratio < 1 это самые долгие из них
+    std::atomic<size_t> nextRun {0};
+    std::atomic<size_t> finishedRuns {0};
+    std::atomic<bool> cancelled {false};
+    const auto running = [this, &cancelled]()
+    {
+        return !cancelled.load(std::memory_order_relaxed)
+               && (m_cancelFlag == nullptr || !m_cancelFlag->load(std::memory_order_relaxed));
+    };
+
+    auto worker = [&]()
+    {
+        for (size_t i = nextRun++; i < m_count && running(); i = nextRun++) {
+            const size_t index = m_count - 1 - i;
+            StiffOdeSolver solver = m_solver;
+            solver.setProgressCallback([&running](double) { return running(); });
+            result.runs[index] = runOne(solver, result.runs[index].parameter, initialConditions, startTime, endTime);
+
+            const double fraction = static_cast<double>(++finishedRuns) / static_cast<double>(m_count);
+            if (m_progress && !m_progress(fraction))
+                cancelled = true;
+        }
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (size_t i = 1; i < threads; ++i)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool)
+        thread.join();
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.elapsedSeconds = elapsed.count();
+
+    // В аппроксимацию порядка идут только прогоны, дошедшие до конца отрезка
+    std::vector<size_t> finished;
+    std::vector<double> parameters;
+    std::vector<double> maxErrors;
+    std::vector<double> rmsErrors;
+    for (size_t i = 0; i < result.runs.size(); ++i) {
+        ConvergenceRun& run = result.runs[i];
+        run.maxErrorPairOrder = std::numeric_limits<double>::quiet_NaN();
+        run.rmsErrorPairOrder = std::numeric_limits<double>::quiet_NaN();
+        if (run.solveResult.status != SolveStatus::Finished)
+            continue;
+        finished.push_back(i);
+        parameters.push_back(run.parameter);
+        maxErrors.push_back(run.maxError);
+        rmsErrors.push_back(run.rmsError);
+    }
+    if (finished.size() < 2)
+        return result;
+
+    const std::vector<double> maxSlopes = pairwiseLogLogSlopes(parameters, maxErrors);
+    const std::vector<double> rmsSlopes = pairwiseLogLogSlopes(parameters, rmsErrors);
+    for (size_t j = 0; j < finished.size(); ++j) {
+        result.runs[finished[j]].maxErrorPairOrder = maxSlopes[j];
+        result.runs[finished[j]].rmsErrorPairOrder = rmsSlopes[j];
+    }
+
+    // Установившийся участок идёт от последнего прогона назад, пока соседние парные порядки близки;
+    // пара j связывает прогоны j - 1 и j
+    const size_t last = finished.size() - 1;
+    size_t tailStart = last;
+    for (size_t j = last; j >= 1 && std::isfinite(maxSlopes[j]); --j) {
+        if (j < last && std::abs(maxSlopes[j] - maxSlopes[j + 1])
+                        > pairOrderTolerance * std::max(1.0, std::abs(maxSlopes[j + 1])))
+            break;
+        tailStart = j - 1;
+    }
+    const bool stable = last - tailStart >= 2;
+    if (!stable)
+        tailStart = last >= 2 ? last - 2 : 0;
+
+    const auto tail = [tailStart](const std::vector<double>& values)
+    {
+        return std::vector<double>(values.begin() + static_cast<std::ptrdiff_t>(tailStart), values.end());
+    };
+    result.fitFirstRun = finished[tailStart];
+    result.maxErrorOrder = fitLogLogSlope(tail(parameters), tail(maxErrors), &result.maxErrorFitResidual);
+    result.rmsErrorOrder = fitLogLogSlope(tail(parameters), tail(rmsErrors));
+    result.orderReliable = stable && result.maxErrorFitResidual <= fitResidualTolerance;
+    return result;
+}
+
+ConvergenceRun ConvergenceStudy::runOne(StiffOdeSolver& solver, double parameter,
+                                        const std::vector<double>& initialConditions, double startTime,
+                                        double endTime) const
+{
+    ConvergenceRun run;
+    run.parameter = parameter;
+
+    SolverOptions options = solver.options();
+    options.storeTrajectory = false;
+    if (m_parameter == StudyParameter::StepSize) {
+        options.stepSize = parameter;
+    }
+    else {
+        options.absTolerance *= parameter / options.relTolerance;
+        options.relTolerance = parameter;
+    }
+    solver.setOptions(options);
+
+    // Погрешность считается в каждом узле по мере счёта
+    const size_t n = initialConditions.size();
+    std::vector<double> exact(n);
+    double sumSquares = 0.0;
+    size_t values = 0;
+    solver.setOutputCallback([&](double t, const double* y)
+    {
+        m_exactSolution(t, exact.data());
+        for (size_t j = 0; j < n; ++j) {
+            const double error = std::abs(y[j] - exact[j]);
+            run.maxError = std::max(run.maxError, error);
+            sumSquares += error * error;
+        }
+        values += n;
+    });
+
+    Trajectory trajectory;
+    const auto start = std::chrono::steady_clock::now();
+    run.solveResult = solver.solve(initialConditions, startTime, endTime, trajectory);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    run.elapsedSeconds = elapsed.count();
+    run.rmsError = values > 0 ? std::sqrt(sumSquares / static_cast<double>(values)) : 0.0;
+    return run;
+}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "StiffOdeSolver.hpp"
+#include "StiffOdeTypes.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace StiffOde
+{
+// Точное решение в момент t: записывает y(t) в y
+using ExactSolution = std::function<void(double t, double* y)>;
+
+enum class StudyParameter
+{
+    StepSize,   // постоянный шаг (неявный метод Эйлера) или начальный шаг адаптивных методов
+    Tolerance   // относительный допуск; абсолютный меняется в той же пропорции
+};
+
+struct ConvergenceRun
+{
+    double parameter = 0.0;
+    double maxError = 0.0;      // максимум |y - y_exact| по узлам решения и компонентам
+    double rmsError = 0.0;      // среднеквадратичная погрешность по тем же значениям
+    // Порядок по паре с предыдущим завершённым прогоном: log(e_prev / e) / log(p_prev / p);
+    // NaN для первого из них и для незавершённых прогонов
+    double maxErrorPairOrder = 0.0;
+    double rmsErrorPairOrder = 0.0;
+    double elapsedSeconds = 0.0;
+    SolveResult solveResult;
+};
+
+struct ConvergenceStudyResult
+{
+    std::vector<ConvergenceRun> runs;   // в порядке first, first * ratio, ...
+    // Наклоны прямых МНК для log(погрешности) от log(параметра): эмпирический порядок по шагу
+    // или показатель зависимости погрешности от допуска. Прямая строится только по прогонам
+    // fitFirstRun..runs.size() - 1, на которых парные порядки по максимальной погрешности установились:
+    // при крупном шаге погрешность ещё не вышла на асимптотику и занизила бы наклон
+    double maxErrorOrder = 0.0;
+    double rmsErrorOrder = 0.0;
+    size_t fitFirstRun = 0;
+    // Среднеквадратичное отклонение точек от прямой, в десятичных порядках погрешности
+    double maxErrorFitResidual = 0.0;
+    // false, если установившийся участок короче трёх прогонов или точки заметно отклоняются от прямой;
+    // тогда порядок - оценка по последним прогонам
+    bool orderReliable = false;
+    double elapsedSeconds = 0.0;
+};
+
+// Наклон прямой МНК по точкам (log x, log y); точки с неположительными координатами пропускаются.
+// В residual, если задан, записывается среднеквадратичное отклонение log10 y от прямой
+double fitLogLogSlope(const std::vector<double>& x, const std::vector<double>& y, double* residual = nullptr);
+// Наклоны по парам соседних точек: log(y_i / y_(i-1)) / log(x_i / x_(i-1)); NaN для i = 0 и для пар
+// с неположительными значениями
+std::vector<double> pairwiseLogLogSlopes(const std::vector<double>& x, const std::vector<double>& y);
+
+// Исследование сходимости: решение одной задачи при параметрах first, first * ratio, ..., first * ratio^(count - 1)
+// и сравнение с точным решением во всех узлах. Прогоны независимы и распределяются по потокам;
+// траектории не сохраняются, погрешность накапливается по мере счёта.
+class ConvergenceStudy
+{
+public:
+    ConvergenceStudy(const StiffOdeSolver& solver, const ExactSolution& exactSolution);
+
+    void setParameter(StudyParameter parameter, double first, double ratio, size_t count);
+    // 0 - по числу аппаратных потоков
+    void setThreadCount(size_t count);
+    // Получает долю завершённых прогонов; вызывается из рабочих потоков, false отменяет оставшиеся прогоны
+    void setProgressCallback(const ProgressCallback& callback);
+    // Флаг отмены извне; проверяется и между прогонами, и внутри каждого из них на каждом шаге
+    void setCancelFlag(const std::atomic<bool>* flag);
+
+    ConvergenceStudyResult run(const std::vector<double>& initialConditions, double startTime, double endTime) const;
+
+private:
+    ConvergenceRun runOne(StiffOdeSolver& solver, double parameter, const std::vector<double>& initialConditions,
+                          double startTime, double endTime) const;
+
+    StiffOdeSolver m_solver;
+    ExactSolution m_exactSolution;
+    ProgressCallback m_progress;
+    const std::atomic<bool>* m_cancelFlag {nullptr};
+    StudyParameter m_parameter {StudyParameter::StepSize};
+    double m_first {0.1};
+    double m_ratio {0.5};
+    size_t m_count {8};
+    size_t m_threadCount {0};
+};
+}
@@ -0,0 +1,126 @@
+#include "StiffOdeConvergenceWidget.hpp"
+
+#include <QHBoxLayout>
+#include <QTextEdit>
+#include <QVBoxLayout>
+#include <QtCharts/QChartView>
+#include <QtCharts/QLineSeries>
+#include <QtCharts/QLogValueAxis>
+
+#include <cmath>
+
+namespace StiffOde
+{
+StiffOdeConvergenceWidget::StiffOdeConvergenceWidget(const ConvergenceStudyResult& result,
+                                                     StudyParameter parameter, QWidget* parent)
+    : QWidget(parent),
+    m_result(result),
+    m_parameter(parameter)
+{
+    const QString parameterName = m_parameter == StudyParameter::StepSize ? "Шаг h" : "Допуск rtol";
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    QHBoxLayout* chartsLayout = new QHBoxLayout();
+
+    QChartView* parameterChartView = new QChartView(this);
+    parameterChartView->setChart(createChart("Погрешность от параметра", parameterName, false));
+    parameterChartView->setRenderHint(QPainter::Antialiasing);
+    chartsLayout->addWidget(parameterChartView);
+
+    QChartView* timeChartView = new QChartView(this);
+    timeChartView->setChart(createChart("Погрешность от времени счёта", "Время, с", true));
+    timeChartView->setRenderHint(QPainter::Antialiasing);
+    chartsLayout->addWidget(timeChartView);
+
+    layout->addLayout(chartsLayout);
+
+    QTextEdit* summaryText = new QTextEdit(this);
+    summaryText->setReadOnly(true);
+    summaryText->setMaximumHeight(200);
+    summaryText->setText(summary());
+    layout->addWidget(summaryText);
+
+    setLayout(layout);
+}
+
+QChart* StiffOdeConvergenceWidget::createChart(const QString& title, const QString& axisTitle, bool byTime) const
+{
+    auto* maxSeries = new QtCharts::QLineSeries();
+    auto* rmsSeries = new QtCharts::QLineSeries();
+    maxSeries->setName("Максимальная погрешность");
+    rmsSeries->setName("Среднеквадратичная погрешность");
+    maxSeries->setPointsVisible(true);
+    rmsSeries->setPointsVisible(true);
+
+    // На логарифмической оси допустимы только положительные значения
+    for (const ConvergenceRun& run : m_result.runs) {
+        const double x = byTime ? run.elapsedSeconds : run.parameter;
+        if (x <= 0.0)
+            continue;
+        if (run.maxError > 0.0)
+            maxSeries->append(x, run.maxError);
+        if (run.rmsError > 0.0)
+            rmsSeries->append(x, run.rmsError);
+    }
+
+    QChart* chart = new QChart();
+    chart->addSeries(maxSeries);
+    chart->addSeries(rmsSeries);
+    chart->setTitle(title);
+
+    auto* axisX = new QtCharts::QLogValueAxis();
+    axisX->setTitleText(axisTitle);
+    axisX->setLabelFormat("%.0e");
+    axisX->setBase(10.0);
+    chart->addAxis(axisX, Qt::AlignBottom);
+
+    auto* axisY = new QtCharts::QLogValueAxis();
+    axisY->setTitleText("Глобальная погрешность");
+    axisY->setLabelFormat("%.0e");
+    axisY->setBase(10.0);
+    chart->addAxis(axisY, Qt::AlignLeft);
+
+    for (auto* series : { maxSeries, rmsSeries }) {
+        series->attachAxis(axisX);
+        series->attachAxis(axisY);
+    }
+    return chart;
+}
+
+QString StiffOdeConvergenceWidget::summary() const
+{
+    const bool byStep = m_parameter == StudyParameter::StepSize;
+
+    QString text;
+    text += byStep ? "Эмпирический порядок по шагу: " : "Показатель погрешности по допуску: ";
+    text += QString("%1 (максимальная погрешность), %2 (среднеквадратичная)\n")
+                .arg(m_result.maxErrorOrder, 0, 'f', 3)
+                .arg(m_result.rmsErrorOrder, 0, 'f', 3);
+    text += QString("Прямая построена по прогонам %1-%2, отклонение точек %3 десятичного порядка\n")
+                .arg(m_result.fitFirstRun + 1)
+                .arg(m_result.runs.size())
+                .arg(m_result.maxErrorFitResidual, 0, 'f', 3);
+    if (!m_result.orderReliable)
+        text += "Парные порядки не установились: оценка ненадёжна, нужны более мелкие шаги или допуски\n";
+    text += QString("Прогонов: %1, общее время: %2 с\n\n").arg(m_result.runs.size()).arg(m_result.elapsedSeconds);
+
+    text += QString(byStep ? "h" : "rtol");
+    text += "\tмакс. погрешность\tср.-кв. погрешность\tпорядок (макс.)\tпорядок (ср.-кв.)"
+            "\tвремя, с\tпринятых шагов\tотклонённых шагов\n";
+    for (const ConvergenceRun& run : m_result.runs) {
+        // Парный порядок - по отношению к предыдущему завершённому прогону
+        const auto pairOrder = [](double order) { return std::isfinite(order) ? QString::number(order, 'f', 3) : "-"; };
+        text += QString("%1\t%2\t%3\t%4\t%5\t%6\t%7\t%8%9\n")
+                    .arg(run.parameter, 0, 'g', 6)
+                    .arg(run.maxError, 0, 'e', 4)
+                    .arg(run.rmsError, 0, 'e', 4)
+                    .arg(pairOrder(run.maxErrorPairOrder))
+                    .arg(pairOrder(run.rmsErrorPairOrder))
+                    .arg(run.elapsedSeconds, 0, 'g', 4)
+                    .arg(run.solveResult.acceptedSteps)
+                    .arg(run.solveResult.rejectedSteps)
+                    .arg(run.solveResult.status == SolveStatus::Finished ? "" : "\t(не завершён)");
+    }
+    return text;
+}
+}
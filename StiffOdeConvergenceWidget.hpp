@@ -0,0 +1,29 @@
+#pragma once
+
+#include "StiffOdeConvergence.hpp"
+
+#include <QWidget>
+#include <QtCharts/QChart>
+
+using namespace QtCharts;
+
+namespace StiffOde
+{
+// Результаты исследования сходимости: погрешность от параметра и от времени счёта в логарифмических осях
+// и таблица прогонов с эмпирическим порядком.
+class StiffOdeConvergenceWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    StiffOdeConvergenceWidget(const ConvergenceStudyResult& result, StudyParameter parameter,
+                              QWidget* parent = nullptr);
+
+private:
+    QChart* createChart(const QString& title, const QString& axisTitle, bool byTime) const;
+    QString summary() const;
+
+    ConvergenceStudyResult m_result;
+    StudyParameter m_parameter;
+};
+}
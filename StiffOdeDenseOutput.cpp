@@ -0,0 +1,127 @@
+#include "StiffOdeDenseOutput.hpp"
+#include "StiffOdeLinearSolver.hpp"
+
+#include <algorithm>
+
+namespace StiffOde
+{
+DenseOutput::DenseOutput(const TrajectoryData& trajectory, const InPlaceSystem& system)
+    : m_trajectory(trajectory),
+    m_system(system)
+{
+    const Eigen::Index n = static_cast<Eigen::Index>(trajectory.numComponents());
+    m_y0.resize(n);
+    m_y1.resize(n);
+    if (m_system) {
+        m_f0.resize(n);
+        m_f1.resize(n);
+    }
+}
+
+double DenseOutput::startTime() const
+{
+    return m_trajectory.time(0);
+}
+
+double DenseOutput::endTime() const
+{
+    return m_trajectory.time(m_trajectory.size() - 1);
+}
+
+bool DenseOutput::contains(double t) const
+{
+    return !m_trajectory.empty() && t >= startTime() && t <= endTime();
+}
+
+void DenseOutput::evaluate(double t, Vector& y)
+{
+    y.resize(m_y0.size());
+    evaluate(t, y.data());
+}
+
+void DenseOutput::evaluate(double t, double* y)
+{
+    const Eigen::Index n = m_y0.size();
+    Eigen::Map<Vector> result(y, n);
+
+    if (m_trajectory.size() == 1) {
+        for (Eigen::Index j = 0; j < n; ++j)
+            y[j] = m_trajectory.value(static_cast<size_t>(j), 0);
+        return;
+    }
+
+    const size_t interval = findInterval(t);
+    if (interval != m_interval)
+        loadInterval(interval);
+
+    const double t0 = m_trajectory.time(interval);
+    const double h = m_trajectory.time(interval + 1) - t0;
+    const double s = h > 0.0 ? (t - t0) / h : 0.0;
+
+    if (!m_system) {
+        result.noalias() = m_y0 + s * (m_y1 - m_y0);
+        return;
+    }
+
+    // Базисные многочлены Эрмита на [0, 1]
+    const double s2 = s * s;
+    const double s3 = s2 * s;
+    const double h00 = 2.0 * s3 - 3.0 * s2 + 1.0;
+    const double h10 = s3 - 2.0 * s2 + s;
+    const double h01 = -2.0 * s3 + 3.0 * s2;
+    const double h11 = s3 - s2;
+
+    result.noalias() = h00 * m_y0 + h01 * m_y1 + (h * h10) * m_f0 + (h * h11) * m_f1;
+}
+
+size_t DenseOutput::findInterval(double t) const
+{
+    const size_t last = m_trajectory.size() - 2;
+
+    // Чаще всего запрос попадает в текущий или следующий шаг
+    if (m_interval != noInterval) {
+        if (t >= m_trajectory.time(m_interval) && t <= m_trajectory.time(m_interval + 1))
+            return m_interval;
+        if (m_interval < last && t >= m_trajectory.time(m_interval + 1) && t <= m_trajectory.time(m_interval + 2))
+            return m_interval + 1;
+    }
+
+    // Последний узел с time <= t
+    size_t low = 0;
+    size_t high = last + 1;
+    while (high - low > 1) {
+        const size_t middle = low + (high - low) / 2;
+        if (m_trajectory.time(middle) <= t)
+            low = middle;
+        else
+            high = middle;
+    }
+    return std::min(low, last);
+}
+
+void DenseOutput::loadInterval(size_t interval)
+{
+    const Eigen::Index n = m_y0.size();
+    const bool next = m_interval != noInterval && interval == m_interval + 1;
+
+    // При переходе на следующий шаг его левый конец уже загружен
+    if (next) {
+        m_y0.swap(m_y1);
+        if (m_system)
+            m_f0.swap(m_f1);
+    }
+    else {
+        for (Eigen::Index j = 0; j < n; ++j)
+            m_y0[j] = m_trajectory.value(static_cast<size_t>(j), interval);
+        if (m_system)
+            StiffOde::evaluate(m_system, m_trajectory.time(interval), m_y0, m_f0);
+    }
+
+    for (Eigen::Index j = 0; j < n; ++j)
+        m_y1[j] = m_trajectory.value(static_cast<size_t>(j), interval + 1);
+    if (m_system)
+        StiffOde::evaluate(m_system, m_trajectory.time(interval + 1), m_y1, m_f1);
+
+    m_interval = interval;
+}
+}
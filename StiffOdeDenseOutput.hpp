@@ -0,0 +1,43 @@
+#pragma once
+
+#include "StiffOdeTrajectory.hpp"
+#include "StiffOdeTypes.hpp"
+
+#include <cstddef>
+#include <limits>
+
+namespace StiffOde
+{
+// Непрерывное продолжение численного решения между узлами траектории.
+// С правой частью - кубический эрмитов сплайн по y и f в концах шага (TR-BDF2, третий порядок);
+// без неё - линейная интерполяция, совпадающая с коллокационным многочленом неявного метода Эйлера
+// и не дающая выбросов на жёстких компонентах при больших шагах.
+class DenseOutput
+{
+public:
+    explicit DenseOutput(const TrajectoryData& trajectory, const InPlaceSystem& system = {});
+
+    double startTime() const;
+    double endTime() const;
+    bool contains(double t) const;
+
+    // y(t) для t из [startTime(), endTime()]; последовательные запросы по возрастанию t
+    // обходятся без поиска и повторного вычисления правой части
+    void evaluate(double t, double* y);
+    void evaluate(double t, Vector& y);
+
+private:
+    static constexpr size_t noInterval = std::numeric_limits<size_t>::max();
+
+    size_t findInterval(double t) const;
+    void loadInterval(size_t interval);
+
+    const TrajectoryData& m_trajectory;
+    InPlaceSystem m_system;
+    size_t m_interval {noInterval};
+    Vector m_y0;
+    Vector m_y1;
+    Vector m_f0;
+    Vector m_f1;
+};
+}
@@ -0,0 +1,706 @@
+#include "StiffOdeEnsemble.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace StiffOde
+{
+namespace
+{
+// Требуемая точность итераций Ньютона во взвешенной норме, как в StiffOdeSolver::solveTrBdf2:
+// погрешность итераций входит во вложенную оценку погрешности шага
+const double newtonTolerance = 0.003;
+
+double differenceIncrement(double y)
+{
+    static const double sqrtEps = std::sqrt(std::numeric_limits<double>::epsilon());
+    return sqrtEps * std::max(1e-5, std::abs(y));
+}
+
+// Рабочие массивы одного блока ансамбля; у каждого потока свой экземпляр.
+// Все массивы хранят дорожки (члены ансамбля) подряд: элемент i дорожки k - [i * width + k].
+class EnsembleBlock
+{
+public:
+    EnsembleBlock(const EnsembleSystem& system, const EnsembleJacobian& jacobian, const SolverOptions& options,
+                  size_t size, size_t numParameters, size_t width);
+
+    // Недостающие до ширины блока дорожки заполняются копией последнего члена и не участвуют в счёте
+    void load(const Matrix& initialConditions, const Matrix& parameters, size_t first, size_t count,
+              double startTime);
+    void run(double endTime);
+    void store(EnsembleResult& result, size_t first, size_t count) const;
+
+    size_t acceptedSteps() const;
+    size_t rejectedSteps() const;
+
+private:
+    void rhs(const double* t, const double* y, double* dydt);
+    void evaluateJacobian();
+    void factorize();
+    void solveLinear(const double* b, double* x) const;
+    void newton(const double* stageRhs, double* z);
+    double laneNorm(const double* v, const double* scale, size_t k) const;
+    double laneErrorNorm(size_t k) const;
+    bool laneBelowThreshold(size_t k) const;
+
+    const EnsembleSystem& m_system;
+    const EnsembleJacobian& m_jacobian;
+    const SolverOptions& m_options;
+    const size_t m_n;
+    const size_t m_numParameters;
+    const size_t m_width;
+
+    std::vector<double> m_parameters;
+    // Состояние дорожек
+    std::vector<double> m_t;
+    std::vector<double> m_h;
+    std::vector<double> m_hGamma;
+    std::vector<double> m_stageTime;
+    std::vector<double> m_convergenceFactor;
+    std::vector<SolveStatus> m_status;
+    std::vector<char> m_active;
+    std::vector<char> m_ok;
+    std::vector<char> m_lastStep;
+    std::vector<char> m_rejectedLast;
+    std::vector<size_t> m_accepted;
+    std::vector<size_t> m_rejected;
+    // Векторы по компонентам
+    std::vector<double> m_y;
+    std::vector<double> m_f;
+    std::vector<double> m_scale;
+    std::vector<double> m_rhs2;
+    std::vector<double> m_rhs3;
+    std::vector<double> m_z2;
+    std::vector<double> m_z3;
+    std::vector<double> m_k2;
+    std::vector<double> m_k3;
+    std::vector<double> m_fz;
+    std::vector<double> m_residual;
+    std::vector<double> m_delta;
+    std::vector<double> m_work;
+    std::vector<double> m_error;
+    std::vector<double> m_perturbed;
+    // Матрицы n x n по дорожкам и перестановки LU
+    std::vector<double> m_jacobianValues;
+    std::vector<double> m_lu;
+    std::vector<size_t> m_pivots;
+    // Для итераций Ньютона
+    std::vector<char> m_converged;
+    std::vector<double> m_previousNorm;
+    std::vector<double> m_eta;
+};
+
+EnsembleBlock::EnsembleBlock(const EnsembleSystem& system, const EnsembleJacobian& jacobian,
+                             const SolverOptions& options, size_t size, size_t numParameters, size_t width)
+    : m_system(system), m_jacobian(jacobian), m_options(options), m_n(size), m_numParameters(numParameters),
+    m_width(width),
+    m_parameters(numParameters * width),
+    m_t(width), m_h(width), m_hGamma(width), m_stageTime(width), m_convergenceFactor(width),
+    m_status(width), m_active(width), m_ok(width), m_lastStep(width), m_rejectedLast(width),
+    m_accepted(width), m_rejected(width),
+    m_y(size * width), m_f(size * width), m_scale(size * width), m_rhs2(size * width), m_rhs3(size * width),
+    m_z2(size * width), m_z3(size * width), m_k2(size * width), m_k3(size * width), m_fz(size * width),
+    m_residual(size * width), m_delta(size * width), m_work(size * width), m_error(size * width),
+    m_perturbed(size * width),
+    m_jacobianValues(size * size * width), m_lu(size * size * width), m_pivots(size * width),
+    m_converged(width), m_previousNorm(width), m_eta(width)
+{
+}
+
+void EnsembleBlock::load(const Matrix& initialConditions, const Matrix& parameters, size_t first, size_t count,
+                         double startTime)
+{
+    const size_t w = m_width;
+
+    for (size_t k = 0; k < w; ++k) {
+        const Eigen::Index member = static_cast<Eigen::Index>(first + std::min(k, count - 1));
+        for (size_t i = 0; i < m_n; ++i)
+            m_y[i * w + k] = initialConditions(static_cast<Eigen::Index>(i), member);
+        for (size_t p = 0; p < m_numParameters; ++p)
+            m_parameters[p * w + k] = parameters(static_cast<Eigen::Index>(p), member);
+
+        m_t[k] = startTime;
+        m_status[k] = SolveStatus::Finished;
+        m_active[k] = k < count;
+        m_rejectedLast[k] = false;
+        m_convergenceFactor[k] = 1.0;
+        m_accepted[k] = 0;
+        m_rejected[k] = 0;
+    }
+
+    rhs(m_t.data(), m_y.data(), m_f.data());
+
+    // Начальный шаг по той же оценке, что и в StiffOdeSolver
+    for (size_t k = 0; k < w; ++k) {
+        if (m_options.stepSize > 0.0) {
+            m_h[k] = m_options.stepSize;
+            continue;
+        }
+        double d0 = 0.0;
+        double d1 = 0.0;
+        for (size_t i = 0; i < m_n; ++i) {
+            const double scale = m_options.absTolerance + m_options.relTolerance * std::abs(m_y[i * w + k]);
+            d0 += (m_y[i * w + k] / scale) * (m_y[i * w + k] / scale);
+            d1 += (m_f[i * w + k] / scale) * (m_f[i * w + k] / scale);
+        }
+        d0 = std::sqrt(d0 / static_cast<double>(m_n));
+        d1 = std::sqrt(d1 / static_cast<double>(m_n));
+        m_h[k] = (d0 < 1e-5 || d1 < 1e-5) ? 1e-6 : 0.01 * d0 / d1;
+    }
+}
+
+void EnsembleBlock::rhs(const double* t, const double* y, double* dydt)
+{
+    m_system(m_width, t, y, m_parameters.data(), dydt);
+}
+
+void EnsembleBlock::evaluateJacobian()
+{
+    const size_t w = m_width;
+
+    if (m_jacobian) {
+        m_jacobian(w, m_t.data(), m_y.data(), m_parameters.data(), m_jacobianValues.data());
+        return;
+    }
+
+    // Конечные разности: столбец c для всех дорожек за одно вычисление правой части
+    for (size_t c = 0; c < m_n; ++c) {
+        std::copy(m_y.begin(), m_y.end(), m_perturbed.begin());
+        for (size_t k = 0; k < w; ++k)
+            m_perturbed[c * w + k] += differenceIncrement(m_y[c * w + k]);
+
+        rhs(m_t.data(), m_perturbed.data(), m_fz.data());
+
+        for (size_t r = 0; r < m_n; ++r) {
+            double* column = &m_jacobianValues[(r * m_n + c) * w];
+            const double* fPerturbed = &m_fz[r * w];
+            const double* f = &m_f[r * w];
+            for (size_t k = 0; k < w; ++k)
+                column[k] = (fPerturbed[k] - f[k]) / (m_perturbed[c * w + k] - m_y[c * w + k]);
+        }
+    }
+}
+
+// LU-разложение I - hGamma * J с выбором главного элемента по столбцу отдельно для каждой дорожки.
+// Перестановки строк скалярные, исключение идёт по дорожкам во внутреннем цикле.
+void EnsembleBlock::factorize()
+{
+    const size_t w = m_width;
+    const size_t n = m_n;
+
+    for (size_t r = 0; r < n; ++r) {
+        for (size_t c = 0; c < n; ++c) {
+            double* a = &m_lu[(r * n + c) * w];
+            const double* jac = &m_jacobianValues[(r * n + c) * w];
+            const double identity = r == c ? 1.0 : 0.0;
+            for (size_t k = 0; k < w; ++k)
+                a[k] = identity - m_hGamma[k] * jac[k];
+        }
+    }
+
+    for (size_t c = 0; c < n; ++c) {
+        for (size_t k = 0; k < w; ++k) {
+            size_t pivot = c;
+            double pivotValue = std::abs(m_lu[(c * n + c) * w + k]);
+            for (size_t r = c + 1; r < n; ++r) {
+                const double value = std::abs(m_lu[(r * n + c) * w + k]);
+                if (value > pivotValue) {
+                    pivot = r;
+                    pivotValue = value;
+                }
+            }
+            m_pivots[c * w + k] = pivot;
+
+            if (pivotValue == 0.0) {
+                // Вырожденная матрица: шаг дорожки будет отклонён, а матрица заменена единичной
+                m_ok[k] = false;
+                for (size_t r = 0; r < n; ++r)
+                    m_lu[(r * n + c) * w + k] = r == c ? 1.0 : 0.0;
+                continue;
+            }
+            if (pivot != c) {
+                for (size_t j = 0; j < n; ++j)
+                    std::swap(m_lu[(c * n + j) * w + k], m_lu[(pivot * n + j) * w + k]);
+            }
+        }
+
+        const double* diagonal = &m_lu[(c * n + c) * w];
+        for (size_t r = c + 1; r < n; ++r) {
+            double* multiplier = &m_lu[(r * n + c) * w];
+            for (size_t k = 0; k < w; ++k)
+                multiplier[k] /= diagonal[k];
+
+            for (size_t j = c + 1; j < n; ++j) {
+                double* target = &m_lu[(r * n + j) * w];
+                const double* source = &m_lu[(c * n + j) * w];
+                for (size_t k = 0; k < w; ++k)
+                    target[k] -= multiplier[k] * source[k];
+            }
+        }
+    }
+}
+
+void EnsembleBlock::solveLinear(const double* b, double* x) const
+{
+    const size_t w = m_width;
+    const size_t n = m_n;
+
+    if (x != b)
+        std::copy(b, b + n * w, x);
+
+    for (size_t c = 0; c < n; ++c) {
+        for (size_t k = 0; k < w; ++k) {
+            const size_t pivot = m_pivots[c * w + k];
+            if (pivot != c)
+                std::swap(x[c * w + k], x[pivot * w + k]);
+        }
+    }
+
+    for (size_t r = 1; r < n; ++r) {
+        double* xr = &x[r * w];
+        for (size_t c = 0; c < r; ++c) {
+            const double* l = &m_lu[(r * n + c) * w];
+            const double* xc = &x[c * w];
+            for (size_t k = 0; k < w; ++k)
+                xr[k] -= l[k] * xc[k];
+        }
+    }
+
+    for (size_t r = n; r-- > 0;) {
+        double* xr = &x[r * w];
+        for (size_t c = r + 1; c < n; ++c) {
+            const double* u = &m_lu[(r * n + c) * w];
+            const double* xc = &x[c * w];
+            for (size_t k = 0; k < w; ++k)
+                xr[k] -= u[k] * xc[k];
+        }
+        const double* diagonal = &m_lu[(r * n + r) * w];
+        for (size_t k = 0; k < w; ++k)
+            xr[k] /= diagonal[k];
+    }
+}
+
+double EnsembleBlock::laneNorm(const double* v, const double* scale, size_t k) const
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < m_n; ++i) {
+        const double scaled = v[i * m_width + k] / scale[i * m_width + k];
+        sum += scaled * scaled;
+    }
+    return std::sqrt(sum / static_cast<double>(m_n));
+}
+
+double EnsembleBlock::laneErrorNorm(size_t k) const
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < m_n; ++i) {
+        const size_t index = i * m_width + k;
+        const double scale = m_options.absTolerance
+                             + m_options.relTolerance * std::max(std::abs(m_y[index]), std::abs(m_z3[index]));
+        const double scaled = m_error[index] / scale;
+        sum += scaled * scaled;
+    }
+    return std::sqrt(sum / static_cast<double>(m_n));
+}
+
+bool EnsembleBlock::laneBelowThreshold(size_t k) const
+{
+    if (m_options.stopThreshold <= 0.0)
+        return false;
+    for (size_t i = 0; i < m_n; ++i) {
+        if (std::abs(m_y[i * m_width + k]) > m_options.stopThreshold)
+            return false;
+    }
+    return true;
+}
+
+// Упрощённый метод Ньютона для z - hGamma * f(z) = stageRhs по всем дорожкам сразу.
+// Сошедшиеся и отказавшие дорожки перестают обновляться; m_ok сбрасывается у отказавших.
+void EnsembleBlock::newton(const double* stageRhs, double* z)
+{
+    const size_t w = m_width;
+
+    for (size_t k = 0; k < w; ++k) {
+        m_converged[k] = !m_active[k] || !m_ok[k];
+        m_eta[k] = std::pow(std::max(m_convergenceFactor[k], std::numeric_limits<double>::epsilon()), 0.8);
+        m_previousNorm[k] = 0.0;
+    }
+
+    for (size_t iteration = 0; iteration < m_options.maxNewtonIterations; ++iteration) {
+        if (std::all_of(m_converged.begin(), m_converged.end(), [](char converged) { return converged; }))
+            return;
+
+        rhs(m_stageTime.data(), z, m_fz.data());
+        for (size_t i = 0; i < m_n; ++i) {
+            for (size_t k = 0; k < w; ++k) {
+                const size_t index = i * w + k;
+                m_residual[index] = z[index] - m_hGamma[k] * m_fz[index] - stageRhs[index];
+            }
+        }
+        solveLinear(m_residual.data(), m_delta.data());
+
+        for (size_t i = 0; i < m_n; ++i) {
+            for (size_t k = 0; k < w; ++k) {
+                if (!m_converged[k])
+                    z[i * w + k] -= m_delta[i * w + k];
+            }
+        }
+
+        for (size_t k = 0; k < w; ++k) {
+            if (m_converged[k])
+                continue;
+
+            const double norm = laneNorm(m_delta.data(), m_scale.data(), k);
+            bool failed = !std::isfinite(norm);
+            if (!failed && iteration > 0) {
+                const double rate = norm / m_previousNorm[k];
+                failed = rate >= 0.9;
+                m_eta[k] = rate / (1.0 - rate);
+            }
+
+            if (failed) {
+                m_converged[k] = true;
+                m_ok[k] = false;
+                m_convergenceFactor[k] = 1.0;
+            }
+            else if (norm == 0.0 || m_eta[k] * norm <= newtonTolerance) {
+                m_converged[k] = true;
+                m_convergenceFactor[k] = m_eta[k];
+            }
+            m_previousNorm[k] = norm;
+        }
+    }
+
+    for (size_t k = 0; k < w; ++k) {
+        if (!m_converged[k]) {
+            m_ok[k] = false;
+            m_convergenceFactor[k] = 1.0;
+        }
+    }
+}
+
+// TR-BDF2 в той же форме ESDIRK, что и StiffOdeSolver::solveTrBdf2, с шагом и его принятием по дорожкам
+void EnsembleBlock::run(double endTime)
+{
+    const double gamma = 2.0 - std::sqrt(2.0);
+    const double d = gamma / 2.0;
+    const double w = std::sqrt(2.0) / 4.0;
+    const double e1 = w - (1.0 - w) / 3.0;
+    const double e2 = w - (3.0 * w + 1.0) / 3.0;
+    const double e3 = 2.0 * d / 3.0;
+
+    const double safety = 0.9;
+    const double minFactor = 0.2;
+    const double maxFactor = 5.0;
+    const double keepStepFactor = 1.2;
+
+    const size_t width = m_width;
+    const size_t size = m_n * width;
+
+    for (;;) {
+        bool anyActive = false;
+        for (size_t k = 0; k < width; ++k) {
+            m_ok[k] = m_active[k];
+            m_hGamma[k] = 0.0;
+            if (!m_active[k])
+                continue;
+
+            if (laneBelowThreshold(k))
+                m_status[k] = SolveStatus::BelowThreshold;
+            else if (m_accepted[k] + m_rejected[k] >= m_options.maxSteps)
+                m_status[k] = SolveStatus::MaxStepsExceeded;
+            else {
+                if (m_options.maxStepSize > 0.0)
+                    m_h[k] = std::min(m_h[k], m_options.maxStepSize);
+
+                const double remaining = endTime - m_t[k];
+                m_lastStep[k] = m_h[k] >= remaining || remaining - m_h[k] < m_options.minStepSize;
+                if (m_lastStep[k])
+                    m_h[k] = remaining;
+
+                if (m_h[k] < m_options.minStepSize)
+                    m_status[k] = SolveStatus::StepSizeTooSmall;
+            }
+
+            if (m_status[k] != SolveStatus::Finished) {
+                m_active[k] = false;
+                m_ok[k] = false;
+                continue;
+            }
+
+            anyActive = true;
+            m_hGamma[k] = d * m_h[k];
+            for (size_t i = 0; i < m_n; ++i)
+                m_scale[i * width + k] = m_options.absTolerance
+                                         + m_options.relTolerance * std::abs(m_y[i * width + k]);
+        }
+
+        if (!anyActive)
+            return;
+
+        // Свежий Якобиан на каждый шаг: дорожки шагают независимо, и общий устаревший Якобиан не отследить
+        evaluateJacobian();
+        factorize();
+
+        // Стадия трапеций
+        for (size_t k = 0; k < width; ++k)
+            m_stageTime[k] = m_t[k] + gamma * m_h[k];
+        for (size_t index = 0; index < size; ++index) {
+            const size_t k = index % width;
+            m_rhs2[index] = m_y[index] + m_hGamma[k] * m_f[index];
+            m_z2[index] = m_y[index];
+        }
+        newton(m_rhs2.data(), m_z2.data());
+
+        // Стадия BDF2
+        for (size_t k = 0; k < width; ++k)
+            m_stageTime[k] = m_t[k] + m_h[k];
+        for (size_t index = 0; index < size; ++index) {
+            const size_t k = index % width;
+            const double hGamma = m_hGamma[k] > 0.0 ? m_hGamma[k] : 1.0;
+            m_k2[index] = (m_z2[index] - m_rhs2[index]) / hGamma;
+            m_rhs3[index] = m_y[index] + w * m_h[k] * (m_f[index] + m_k2[index]);
+            m_z3[index] = m_y[index] + (m_z2[index] - m_y[index]) / gamma;
+        }
+        newton(m_rhs3.data(), m_z3.data());
+
+        // Оценка погрешности, сглаженная матрицей (I - d*h*J)
+        for (size_t index = 0; index < size; ++index) {
+            const size_t k = index % width;
+            const double hGamma = m_hGamma[k] > 0.0 ? m_hGamma[k] : 1.0;
+            m_k3[index] = (m_z3[index] - m_rhs3[index]) / hGamma;
+            m_work[index] = m_h[k] * (e1 * m_f[index] + e2 * m_k2[index] + e3 * m_k3[index]);
+        }
+        solveLinear(m_work.data(), m_error.data());
+
+        bool anyAccepted = false;
+        for (size_t k = 0; k < width; ++k) {
+            if (!m_active[k])
+                continue;
+
+            if (!m_ok[k]) {
+                ++m_rejected[k];
+                m_rejectedLast[k] = true;
+                m_h[k] *= 0.25;
+                continue;
+            }
+
+            const double norm = laneErrorNorm(k);
+            double factor = norm > 0.0 ? safety * std::pow(norm, -1.0 / 3.0) : maxFactor;
+            factor = std::clamp(factor, minFactor, m_rejectedLast[k] ? 1.0 : maxFactor);
+            if (factor >= 1.0 && factor < keepStepFactor)
+                factor = 1.0;
+
+            if (norm <= 1.0) {
+                m_t[k] = m_lastStep[k] ? endTime : m_t[k] + m_h[k];
+                for (size_t i = 0; i < m_n; ++i)
+                    m_y[i * width + k] = m_z3[i * width + k];
+                ++m_accepted[k];
+                m_rejectedLast[k] = false;
+                anyAccepted = true;
+
+                if (m_t[k] >= endTime)
+                    m_active[k] = false;
+            }
+            else {
+                ++m_rejected[k];
+                m_rejectedLast[k] = true;
+            }
+
+            m_h[k] *= factor;
+        }
+
+        if (anyAccepted)
+            rhs(m_t.data(), m_y.data(), m_f.data());
+    }
+}
+
+void EnsembleBlock::store(EnsembleResult& result, size_t first, size_t count) const
+{
+    for (size_t k = 0; k < count; ++k) {
+        const Eigen::Index member = static_cast<Eigen::Index>(first + k);
+        for (size_t i = 0; i < m_n; ++i)
+            result.finalStates(static_cast<Eigen::Index>(i), member) = m_y[i * m_width + k];
+        result.stopTimes[first + k] = m_t[k];
+        result.status[first + k] = m_status[k];
+    }
+}
+
+size_t EnsembleBlock::acceptedSteps() const
+{
+    size_t total = 0;
+    for (size_t k = 0; k < m_width; ++k)
+        total += m_accepted[k];
+    return total;
+}
+
+size_t EnsembleBlock::rejectedSteps() const
+{
+    size_t total = 0;
+    for (size_t k = 0; k < m_width; ++k)
+        total += m_rejected[k];
+    return total;
+}
+}
+
+EnsembleSystem ensembleSystem(const InPlaceSystem& system, size_t size)
+{
+    return [system, size, y = std::vector<double>(size), dydt = std::vector<double>(size)]
+        (size_t width, const double* t, const double* block, const double*, double* blockDydt) mutable
+    {
+        for (size_t k = 0; k < width; ++k) {
+            for (size_t i = 0; i < size; ++i)
+                y[i] = block[i * width + k];
+            system(t[k], y.data(), dydt.data());
+            for (size_t i = 0; i < size; ++i)
+                blockDydt[i * width + k] = dydt[i];
+        }
+    };
+}
+
+EnsembleSystem linearEnsembleSystem(const Matrix& a)
+{
+    return [a](size_t width, const double*, const double* y, const double*, double* dydt)
+    {
+        const Eigen::Index n = a.rows();
+        for (Eigen::Index r = 0; r < n; ++r) {
+            double* out = dydt + r * width;
+            std::fill(out, out + width, 0.0);
+            for (Eigen::Index c = 0; c < n; ++c) {
+                const double coefficient = a(r, c);
+                const double* in = y + c * width;
+                for (size_t k = 0; k < width; ++k)
+                    out[k] += coefficient * in[k];
+            }
+        }
+    };
+}
+
+EnsembleJacobian linearEnsembleJacobian(const Matrix& a)
+{
+    return [a](size_t width, const double*, const double*, const double*, double* jacobian)
+    {
+        const Eigen::Index n = a.rows();
+        for (Eigen::Index r = 0; r < n; ++r) {
+            for (Eigen::Index c = 0; c < n; ++c) {
+                double* out = jacobian + (r * n + c) * width;
+                std::fill(out, out + width, a(r, c));
+            }
+        }
+    };
+}
+
+EnsembleSolver::EnsembleSolver(const EnsembleSystem& system, size_t size)
+    : m_system(system), m_size(size)
+{
+}
+
+void EnsembleSolver::setSystem(const EnsembleSystem& system, size_t size)
+{
+    m_system = system;
+    m_size = size;
+}
+
+void EnsembleSolver::setJacobian(const EnsembleJacobian& jacobian)
+{
+    m_jacobian = jacobian;
+}
+
+void EnsembleSolver::setOptions(const SolverOptions& options)
+{
+    m_options = options;
+}
+
+const SolverOptions& EnsembleSolver::options() const
+{
+    return m_options;
+}
+
+void EnsembleSolver::setBlockWidth(size_t width)
+{
+    m_blockWidth = std::max<size_t>(width, 1);
+}
+
+void EnsembleSolver::setThreadCount(size_t count)
+{
+    m_threadCount = count;
+}
+
+void EnsembleSolver::setCancelFlag(const std::atomic<bool>* flag)
+{
+    m_cancelFlag = flag;
+}
+
+EnsembleResult EnsembleSolver::solve(const Matrix& initialConditions, const Matrix& parameters, double startTime,
+                                     double endTime) const
+{
+    const size_t members = static_cast<size_t>(initialConditions.cols());
+
+    EnsembleResult result;
+    result.finalStates = initialConditions;
+    result.stopTimes.assign(members, startTime);
+    result.status.assign(members, SolveStatus::Finished);
+
+    if (!m_system || members == 0 || static_cast<size_t>(initialConditions.rows()) != m_size
+        || (parameters.size() > 0 && static_cast<size_t>(parameters.cols()) != members))
+        return result;
+
+    const size_t numParameters = static_cast<size_t>(parameters.rows());
+    const size_t width = m_blockWidth;
+    const size_t blocks = (members + width - 1) / width;
+    const size_t hardwareThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    const size_t threads = std::min(m_threadCount > 0 ? m_threadCount : hardwareThreads, blocks);
+
+    std::atomic<size_t> nextBlock {0};
+    std::vector<size_t> accepted(threads);
+    std::vector<size_t> rejected(threads);
+
+    // Каждая функция правой части копируется в поток: ensembleSystem хранит внутри рабочие буферы
+    auto worker = [&](size_t index)
+    {
+        const EnsembleSystem system = m_system;
+        const EnsembleJacobian jacobian = m_jacobian;
+        EnsembleBlock block(system, jacobian, m_options, m_size, numParameters, width);
+
+        for (size_t b = nextBlock++; b < blocks; b = nextBlock++) {
+            const size_t first = b * width;
+            const size_t count = std::min(width, members - first);
+            if (m_cancelFlag != nullptr && m_cancelFlag->load(std::memory_order_relaxed)) {
+                std::fill_n(result.status.begin() + static_cast<std::ptrdiff_t>(first), count, SolveStatus::Cancelled);
+                continue;
+            }
+            block.load(initialConditions, parameters, first, count, startTime);
+            block.run(endTime);
+            block.store(result, first, count);
+            accepted[index] += block.acceptedSteps();
+            rejected[index] += block.rejectedSteps();
+        }
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (size_t i = 1; i < threads; ++i)
+        pool.emplace_back(worker, i);
+    worker(0);
+    for (auto& thread : pool)
+        thread.join();
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    for (size_t i = 0; i < threads; ++i) {
+        result.acceptedSteps += accepted[i];
+        result.rejectedSteps += rejected[i];
+    }
+    result.elapsedSeconds = elapsed.count();
+    result.trajectoriesPerSecond = result.elapsedSeconds > 0.0
+                                   ? static_cast<double>(members) / result.elapsedSeconds : 0.0;
+    return result;
+}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "StiffOdeSolver.hpp"
+#include "StiffOdeTypes.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace StiffOde
+{
+// Правая часть для блока из width членов ансамбля в виде структуры массивов:
+// компонента i члена k - y[i * width + k], параметр p члена k - parameters[p * width + k].
+// Цикл по k внутри ядра идёт по непрерывной памяти и векторизуется компилятором.
+using EnsembleSystem = std::function<void(size_t width, const double* t, const double* y,
+                                          const double* parameters, double* dydt)>;
+// Якобиан блока: элемент (r, c) члена k - jacobian[(r * n + c) * width + k]
+using EnsembleJacobian = std::function<void(size_t width, const double* t, const double* y,
+                                            const double* parameters, double* jacobian)>;
+
+// Правая часть ансамбля из правой части одной системы: члены считаются по очереди, без векторизации
+EnsembleSystem ensembleSystem(const InPlaceSystem& system, size_t size);
+// y' = A y для всех членов ансамбля
+EnsembleSystem linearEnsembleSystem(const Matrix& a);
+EnsembleJacobian linearEnsembleJacobian(const Matrix& a);
+
+struct EnsembleResult
+{
+    Matrix finalStates;                 // по столбцу на член ансамбля
+    std::vector<double> stopTimes;
+    std::vector<SolveStatus> status;   // Cancelled - член не решался из-за отмены
+    size_t acceptedSteps = 0;           // суммарно по ансамблю
+    size_t rejectedSteps = 0;
+    double elapsedSeconds = 0.0;
+    double trajectoriesPerSecond = 0.0;
+};
+
+// Решение одной системы для множества начальных условий и параметров методом TR-BDF2.
+// Члены ансамбля обрабатываются блоками по blockWidth, у каждого свои t, шаг и принятие шага;
+// блоки распределяются по потокам.
+class EnsembleSolver
+{
+public:
+    explicit EnsembleSolver(const EnsembleSystem& system = {}, size_t size = 0);
+
+    void setSystem(const EnsembleSystem& system, size_t size);
+    // Если Якобиан не задан, он вычисляется конечными разностями для всего блока сразу
+    void setJacobian(const EnsembleJacobian& jacobian);
+    // Используются допуски, ограничения шага, maxSteps, maxNewtonIterations и stopThreshold
+    void setOptions(const SolverOptions& options);
+    const SolverOptions& options() const;
+    // Число членов в блоке; кратно числу double в SIMD-регистре (4 для AVX2, 8 для AVX-512)
+    void setBlockWidth(size_t width);
+    // 0 - по числу аппаратных потоков
+    void setThreadCount(size_t count);
+    // Флаг отмены извне; проверяется перед каждым блоком, начатые блоки досчитываются
+    void setCancelFlag(const std::atomic<bool>* flag);
+
+    // initialConditions - по столбцу на член ансамбля; parameters - пустая или с тем же числом столбцов
+    EnsembleResult solve(const Matrix& initialConditions, const Matrix& parameters, double startTime,
+                         double endTime) const;
+
+private:
+    EnsembleSystem m_system;
+    EnsembleJacobian m_jacobian;
+    size_t m_size;
+    SolverOptions m_options;
+    size_t m_blockWidth {8};
+    size_t m_threadCount {0};
+    const std::atomic<bool>* m_cancelFlag {nullptr};
+};
+}
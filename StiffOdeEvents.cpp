@@ -0,0 +1,152 @@
+#include "StiffOdeEvents.hpp"
+#include "StiffOdeLinearSolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace StiffOde
+{
+EventLocator::EventLocator(const std::vector<Event>& events, const InPlaceSystem& system, Eigen::Index size)
+    : m_events(events),
+    m_system(system),
+    m_previousValues(events.size()),
+    m_values(events.size()),
+    m_y0(size),
+    m_y1(size),
+    m_f0(size),
+    m_f1(size),
+    m_work(size)
+{
+}
+
+void EventLocator::start(double t, const Vector& y)
+{
+    m_t0 = t;
+    m_y0 = y;
+    for (size_t i = 0; i < m_events.size(); ++i)
+        m_previousValues[i] = m_events[i].function(t, y.data());
+}
+
+bool EventLocator::step(double& t, Vector& y, std::vector<EventOccurrence>& occurrences)
+{
+    m_t1 = t;
+    m_y1 = y;
+
+    std::vector<size_t> triggeredEvents;
+    for (size_t i = 0; i < m_events.size(); ++i) {
+        m_values[i] = m_events[i].function(t, y.data());
+        if (triggered(i, m_previousValues[i], m_values[i]))
+            triggeredEvents.push_back(i);
+    }
+
+    if (!triggeredEvents.empty()) {
+        evaluate(m_system, m_t0, m_y0, m_f0);
+        evaluate(m_system, m_t1, m_y1, m_f1);
+
+        std::vector<std::pair<double, size_t>> roots;
+        roots.reserve(triggeredEvents.size());
+        for (size_t i : triggeredEvents)
+            roots.emplace_back(locate(i, m_previousValues[i]), i);
+        std::stable_sort(roots.begin(), roots.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        for (const auto& [root, i] : roots) {
+            EventOccurrence occurrence;
+            occurrence.event = i;
+            occurrence.t = root;
+            interpolate(root, occurrence.y);
+            occurrence.rising = m_previousValues[i] < 0.0;
+            occurrences.push_back(occurrence);
+
+            if (m_events[i].terminal) {
+                t = root;
+                y = occurrences.back().y;
+                return true;
+            }
+        }
+    }
+
+    std::swap(m_previousValues, m_values);
+    m_t0 = m_t1;
+    m_y0.swap(m_y1);
+    return false;
+}
+
+bool EventLocator::triggered(size_t event, double previous, double current) const
+{
+    const bool rising = previous < 0.0 && current >= 0.0;
+    const bool falling = previous > 0.0 && current <= 0.0;
+    switch (m_events[event].direction) {
+    case EventDirection::Rising:
+        return rising;
+    case EventDirection::Falling:
+        return falling;
+    case EventDirection::Any:
+        break;
+    }
+    return rising || falling;
+}
+
+// Метод Иллинойса: регула фальси, в которой значение на конце, не сдвигавшемся два раза подряд,
+// делится пополам. Возвращается конец отрезка после смены знака, так что в точке события
+// g уже имеет новый знак или равна нулю.
+double EventLocator::locate(size_t event, double previous)
+{
+    const int maxIterations = 100;
+    const double eps = std::numeric_limits<double>::epsilon();
+    const bool rising = previous < 0.0;
+    auto after = [rising](double g) { return rising ? g >= 0.0 : g <= 0.0; };
+
+    double a = m_t0;
+    double b = m_t1;
+    double ga = previous;
+    double gb = m_values[event];
+    int side = 0;
+
+    for (int iteration = 0; iteration < maxIterations && gb != 0.0; ++iteration) {
+        const double width = b - a;
+        if (width <= 4.0 * eps * std::max(std::abs(a), std::abs(b)))
+            break;
+
+        double c = b - gb * width / (gb - ga);
+        // Регула фальси может упереться в конец отрезка; тогда шаг делается делением пополам
+        if (!(c > a && c < b))
+            c = a + 0.5 * width;
+
+        interpolate(c, m_work);
+        const double gc = m_events[event].function(c, m_work.data());
+        if (after(gc)) {
+            b = c;
+            gb = gc;
+            if (side == 1)
+                ga *= 0.5;
+            side = 1;
+        }
+        else {
+            a = c;
+            ga = gc;
+            if (side == -1)
+                gb *= 0.5;
+            side = -1;
+        }
+    }
+    return b;
+}
+
+// Кубический многочлен Эрмита по y и f на концах шага
+void EventLocator::interpolate(double t, Vector& y) const
+{
+    const double h = m_t1 - m_t0;
+    const double s = h > 0.0 ? (t - m_t0) / h : 1.0;
+    const double s2 = s * s;
+    const double s3 = s2 * s;
+    const double h00 = 2.0 * s3 - 3.0 * s2 + 1.0;
+    const double h10 = s3 - 2.0 * s2 + s;
+    const double h01 = -2.0 * s3 + 3.0 * s2;
+    const double h11 = s3 - s2;
+
+    y.noalias() = h00 * m_y0 + h01 * m_y1 + (h * h10) * m_f0 + (h * h11) * m_f1;
+}
+}
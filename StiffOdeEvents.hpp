@@ -0,0 +1,67 @@
+#pragma once
+
+#include "StiffOdeTypes.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace StiffOde
+{
+// Функция события g(t, y): событие происходит, когда g меняет знак
+using EventFunction = std::function<double(double t, const double* y)>;
+
+enum class EventDirection
+{
+    Any,
+    Rising,     // g переходит от отрицательных значений к неотрицательным
+    Falling     // g переходит от положительных значений к неположительным
+};
+
+struct Event
+{
+    EventFunction function;
+    EventDirection direction = EventDirection::Any;
+    bool terminal = false;      // true - решение заканчивается в момент события
+};
+
+struct EventOccurrence
+{
+    size_t event = 0;           // номер события в списке, переданном решателю
+    double t = 0.0;
+    Vector y;
+    bool rising = false;
+};
+
+// Поиск событий на принятых шагах. На каждом шаге вычисляются только функции g в его конце; при смене знака
+// корень уточняется методом Иллинойса по кубическому эрмитову многочлену шага, построенному по y и f
+// на его концах. Правая часть вычисляется лишь на шагах, где событие произошло.
+class EventLocator
+{
+public:
+    EventLocator(const std::vector<Event>& events, const InPlaceSystem& system, Eigen::Index size);
+
+    // Начальная точка решения
+    void start(double t, const Vector& y);
+    // Проверка шага от предыдущей точки до (t, y). События дописываются в occurrences в порядке времени;
+    // при терминальном событии t и y переносятся в точку события и возвращается true
+    bool step(double& t, Vector& y, std::vector<EventOccurrence>& occurrences);
+
+private:
+    bool triggered(size_t event, double previous, double current) const;
+    double locate(size_t event, double previous);
+    void interpolate(double t, Vector& y) const;
+
+    std::vector<Event> m_events;
+    InPlaceSystem m_system;
+    std::vector<double> m_previousValues;
+    std::vector<double> m_values;
+    double m_t0 {0.0};
+    double m_t1 {0.0};
+    Vector m_y0;
+    Vector m_y1;
+    Vector m_f0;
+    Vector m_f1;
+    Vector m_work;
+};
+}
@@ -0,0 +1,106 @@
+#include "StiffOdeExponential.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unsupported/Eigen/MatrixFunctions>
+
+namespace StiffOde
+{
+namespace
+{
+// Столбцы phi_1(X) e_1, ..., phi_order(X) e_1 из экспоненты [[X, e_1, 0], [0, 0, I], [0, 0, 0]] (Sidje, 1998)
+Matrix phiColumns(const Matrix& x, int order)
+{
+    const Eigen::Index m = x.rows();
+    Matrix augmented = Matrix::Zero(m + order, m + order);
+    augmented.topLeftCorner(m, m) = x;
+    augmented(0, m) = 1.0;
+    for (int i = 0; i + 1 < order; ++i)
+        augmented(m + i, m + i + 1) = 1.0;
+
+    const Matrix exponential = augmented.exp();
+    return exponential.block(0, m, m, order);
+}
+}
+
+std::vector<Matrix> phiMatrices(const Matrix& a, double h, int order)
+{
+    const Eigen::Index n = a.rows();
+    const Eigen::Index size = (order + 1) * n;
+
+    Matrix augmented = Matrix::Zero(size, size);
+    augmented.topLeftCorner(n, n) = h * a;
+    for (int k = 0; k < order; ++k)
+        augmented.block(k * n, (k + 1) * n, n, n).setIdentity();
+
+    const Matrix exponential = augmented.exp();
+
+    std::vector<Matrix> phi;
+    phi.reserve(static_cast<size_t>(order) + 1);
+    for (int k = 0; k <= order; ++k)
+        phi.push_back(exponential.block(0, k * n, n, n));
+    return phi;
+}
+
+KrylovPhi::KrylovPhi(Eigen::Index size, Eigen::Index maxDimension)
+    : m_basis(size, maxDimension + 1),
+    m_hessenberg(Matrix::Zero(maxDimension + 1, maxDimension)),
+    m_product(size)
+{
+}
+
+bool KrylovPhi::apply(const LinearOperator& a, double h, const Vector& b, int order, const Vector& scale,
+                      double tolerance, Matrix& phi)
+{
+    const Eigen::Index n = b.size();
+    const Eigen::Index maxDimension = m_hessenberg.cols();
+    phi.setZero(n, order);
+
+    const double beta = b.norm();
+    m_dimension = 0;
+    if (beta == 0.0)
+        return true;
+
+    // Норма, ниже которой поддиагональный элемент означает точное инвариантное подпространство
+    const double breakdown = 1e-12 * beta;
+    m_hessenberg.setZero();
+    m_basis.col(0) = b / beta;
+
+    for (Eigen::Index j = 0; j < maxDimension; ++j) {
+        // Шаг Арнольди с модифицированной ортогонализацией Грама - Шмидта
+        a(m_basis.col(j), m_product);
+        for (Eigen::Index i = 0; i <= j; ++i) {
+            m_hessenberg(i, j) = m_basis.col(i).dot(m_product);
+            m_product -= m_hessenberg(i, j) * m_basis.col(i);
+        }
+        const double next = m_product.norm();
+        m_hessenberg(j + 1, j) = next;
+
+        const Eigen::Index m = j + 1;
+        const bool exact = next <= breakdown;
+        const Matrix columns = phiColumns(h * m_hessenberg.topLeftCorner(m, m), exact ? order : order + 1);
+
+        bool converged = exact;
+        if (!exact) {
+            m_basis.col(m) = m_product / next;
+            const double coefficient = beta * next * h * std::abs(columns(m - 1, order));
+            const double error = coefficient * std::sqrt((m_basis.col(m).array() / scale.array()).square().sum()
+                                                         / static_cast<double>(n));
+            converged = error <= tolerance;
+        }
+
+        if (converged || m == maxDimension) {
+            m_dimension = m;
+            phi.noalias() = beta * m_basis.leftCols(m) * columns.leftCols(order);
+            return converged;
+        }
+    }
+    return false;
+}
+
+Eigen::Index KrylovPhi::dimension() const
+{
+    return m_dimension;
+}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "StiffOdeTypes.hpp"
+
+#include <functional>
+#include <vector>
+
+namespace StiffOde
+{
+// Произведение линейного оператора на вектор: result = A v
+using LinearOperator = std::function<void(const Vector& v, Vector& result)>;
+
+// phi-функции phi_0(z) = e^z, phi_{k+1}(z) = (phi_k(z) - 1/k!) / z.
+// Матрицы phi_0(hA)..phi_order(hA) берутся из верхней блочной строки экспоненты блочной матрицы
+// [[hA, I, 0, ...], [0, 0, I, ...], ..., [0, ..., 0]] размера (order + 1)N, вычисленной Паде
+// с масштабированием и возведением в квадрат. Подходит для небольших N.
+std::vector<Matrix> phiMatrices(const Matrix& a, double h, int order);
+
+// Произведения phi_k(hA) b, k = 1..order, в подпространстве Крылова размерности m (Арнольди):
+// phi_k(hA) b ~ |b| V_m phi_k(h H_m) e_1. Размерность растёт, пока апостериорная оценка
+// |b| h_{m+1,m} |e_m^T phi_{order+1}(h H_m) e_1| не станет меньше допуска. Для A требуется только
+// умножение на вектор, поэтому подходит для больших разреженных систем.
+class KrylovPhi
+{
+public:
+    KrylovPhi(Eigen::Index size, Eigen::Index maxDimension);
+
+    // Столбец k - 1 матрицы phi - phi_k(hA) b. Допуск задаётся в среднеквадратичной норме, взвешенной по scale.
+    // false - размерности maxDimension не хватило для заданного допуска
+    bool apply(const LinearOperator& a, double h, const Vector& b, int order, const Vector& scale,
+               double tolerance, Matrix& phi);
+    // Размерность подпространства при последнем вызове apply()
+    Eigen::Index dimension() const;
+
+private:
+    Matrix m_basis;
+    Matrix m_hessenberg;
+    Vector m_product;
+    Eigen::Index m_dimension {0};
+};
+}
@@ -0,0 +1,446 @@
+#pragma once
+
+#include "StiffOdeSolver.hpp"
+#include "StiffOdeTrajectory.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <Eigen/Dense>
+
+namespace StiffOde
+{
+namespace Detail
+{
+// Конечно-разностный Якобиан для систем фиксированного размера
+template <int N, typename Rhs>
+class FixedDifferenceJacobian
+{
+public:
+    using State = Eigen::Matrix<double, N, 1>;
+    using JacobianMatrix = Eigen::Matrix<double, N, N>;
+
+    explicit FixedDifferenceJacobian(const Rhs& rhs)
+        : m_rhs(rhs)
+    {
+    }
+
+    void operator()(double t, const State& y, JacobianMatrix& jacobian) const
+    {
+        const double sqrtEps = std::sqrt(std::numeric_limits<double>::epsilon());
+        State f;
+        State fPerturbed;
+        State yPerturbed = y;
+        m_rhs(t, y, f);
+        for (int j = 0; j < N; ++j) {
+            const double delta = sqrtEps * std::max(1e-5, std::abs(y[j]));
+            yPerturbed[j] = y[j] + delta;
+            m_rhs(t, yPerturbed, fPerturbed);
+            jacobian.col(j) = (fPerturbed - f) / delta;
+            yPerturbed[j] = y[j];
+        }
+    }
+
+private:
+    const Rhs& m_rhs;
+};
+
+// Упрощённый метод Ньютона с той же политикой переиспользования, что у NewtonSolver,
+// но с матрицами фиксированного размера на стеке
+template <int N, typename Rhs, typename Jacobian>
+class FixedNewton
+{
+public:
+    using State = Eigen::Matrix<double, N, 1>;
+    using JacobianMatrix = Eigen::Matrix<double, N, N>;
+
+    FixedNewton(const Rhs& rhs, const Jacobian& jacobian, size_t maxIterations, double tolerance = 0.03)
+        : m_rhs(rhs), m_jacobianFunction(jacobian), m_maxIterations(maxIterations), m_tolerance(tolerance)
+    {
+    }
+
+    void prepare(double t, const State& y, double hGamma)
+    {
+        m_hGamma = hGamma;
+        m_jacobianCurrent = false;
+
+        if (m_jacobianStale) {
+            m_jacobianFunction(t, y, m_jacobian);
+            m_jacobianStale = false;
+            m_jacobianCurrent = true;
+            m_factorizationStale = true;
+        }
+
+        if (m_factorizationStale || m_hGamma != m_factorizedHGamma) {
+            m_lu.compute(JacobianMatrix::Identity() - m_hGamma * m_jacobian);
+            m_factorizedHGamma = m_hGamma;
+            m_factorizationStale = false;
+        }
+    }
+
+    bool solve(double t, const State& rhs, const State& scale, State& z)
+    {
+        double eta = std::pow(std::max(m_convergenceFactor, std::numeric_limits<double>::epsilon()), 0.8);
+        double previousNorm = 0.0;
+        State f;
+
+        for (size_t k = 0; k < m_maxIterations; ++k) {
+            m_rhs(t, z, f);
+            const State delta = m_lu.solve(z - m_hGamma * f - rhs);
+            z -= delta;
+
+            const double norm = std::sqrt((delta.array() / scale.array()).square().sum() / N);
+            if (!std::isfinite(norm))
+                break;
+
+            double rate = 0.0;
+            if (k > 0) {
+                rate = norm / previousNorm;
+                if (rate >= 0.9)
+                    break;
+                eta = rate / (1.0 - rate);
+            }
+
+            if (norm == 0.0 || eta * norm <= m_tolerance) {
+                m_convergenceFactor = eta;
+                if (rate > 0.3)
+                    m_jacobianStale = true;
+                return true;
+            }
+
+            previousNorm = norm;
+        }
+
+        m_convergenceFactor = 1.0;
+        m_jacobianStale = true;
+        return false;
+    }
+
+    State solveLinear(const State& b) const
+    {
+        return m_lu.solve(b);
+    }
+
+    bool jacobianCurrent() const
+    {
+        return m_jacobianCurrent;
+    }
+
+private:
+    const Rhs& m_rhs;
+    const Jacobian& m_jacobianFunction;
+    size_t m_maxIterations;
+    double m_tolerance;
+
+    JacobianMatrix m_jacobian;
+    Eigen::PartialPivLU<JacobianMatrix> m_lu;
+    double m_hGamma = 0.0;
+    double m_factorizedHGamma = 0.0;
+    double m_convergenceFactor = 1.0;
+    bool m_jacobianStale = true;
+    bool m_jacobianCurrent = false;
+    bool m_factorizationStale = true;
+};
+}
+
+// Решатель для малых систем (обычно 2-8 уравнений), размер которых известен при компиляции.
+// Векторы и матрицы имеют фиксированный размер и живут на стеке, правая часть и Якобиан
+// вызываются напрямую без std::function, так что ядра шага полностью разворачиваются.
+// Поддерживаются неявный метод Эйлера (с шагом SolverOptions::stepSize > 0) и TR-BDF2 с теми же
+// параметрами, что у StiffOdeSolver; для остальных методов solve() возвращает SolveStatus::InvalidOptions.
+// События, чувствительности и вывод через OutputCallback не поддерживаются - для них используется StiffOdeSolver.
+//
+// rhs(t, y, dydt) и jacobian(t, y, J) принимают State и JacobianMatrix.
+template <int N>
+class FixedSizeSolver
+{
+public:
+    using State = Eigen::Matrix<double, N, 1>;
+    using JacobianMatrix = Eigen::Matrix<double, N, N>;
+
+    void setOptions(const SolverOptions& options);
+    const SolverOptions& options() const;
+    void setProgressCallback(const ProgressCallback& callback);
+
+    template <typename Rhs>
+    SolveResult solve(const Rhs& rhs, const State& initialConditions, double startTime, double endTime,
+                      Trajectory& trajectory) const;
+
+    template <typename Rhs, typename Jacobian>
+    SolveResult solve(const Rhs& rhs, const Jacobian& jacobian, const State& initialConditions,
+                      double startTime, double endTime, Trajectory& trajectory) const;
+
+    // Состояние в конце последнего вызова solve(); продолжается StiffOdeSolver::resume() тем же методом
+    const SolverCheckpoint& checkpoint() const;
+    // Число принятых и отброшенных шагов последнего вызова solve()
+    const SolverStatistics& statistics() const;
+
+private:
+    template <typename Rhs, typename Jacobian>
+    SolveResult solveBackwardEuler(const Rhs& rhs, const Jacobian& jacobian, const State& initialConditions,
+                                   double startTime, double endTime, Trajectory& trajectory) const;
+
+    template <typename Rhs, typename Jacobian>
+    SolveResult solveTrBdf2(const Rhs& rhs, const Jacobian& jacobian, const State& initialConditions,
+                            double startTime, double endTime, Trajectory& trajectory) const;
+
+    State errorScale(const State& y) const;
+    SolveResult finish(const SolveResult& result, const State& y, double h) const;
+
+    SolverOptions m_options;
+    ProgressCallback m_progress;
+    mutable SolverCheckpoint m_checkpoint;
+    mutable SolverStatistics m_statistics;
+};
+
+template <int N>
+void FixedSizeSolver<N>::setOptions(const SolverOptions& options)
+{
+    m_options = options;
+}
+
+template <int N>
+const SolverOptions& FixedSizeSolver<N>::options() const
+{
+    return m_options;
+}
+
+template <int N>
+void FixedSizeSolver<N>::setProgressCallback(const ProgressCallback& callback)
+{
+    m_progress = callback;
+}
+
+template <int N>
+const SolverCheckpoint& FixedSizeSolver<N>::checkpoint() const
+{
+    return m_checkpoint;
+}
+
+template <int N>
+const SolverStatistics& FixedSizeSolver<N>::statistics() const
+{
+    return m_statistics;
+}
+
+template <int N>
+template <typename Rhs>
+SolveResult FixedSizeSolver<N>::solve(const Rhs& rhs, const State& initialConditions, double startTime,
+                                      double endTime, Trajectory& trajectory) const
+{
+    const Detail::FixedDifferenceJacobian<N, Rhs> jacobian(rhs);
+    return solve(rhs, jacobian, initialConditions, startTime, endTime, trajectory);
+}
+
+template <int N>
+template <typename Rhs, typename Jacobian>
+SolveResult FixedSizeSolver<N>::solve(const Rhs& rhs, const Jacobian& jacobian, const State& initialConditions,
+                                      double startTime, double endTime, Trajectory& trajectory) const
+{
+    trajectory.reset(N);
+    m_statistics = SolverStatistics();
+    m_checkpoint = SolverCheckpoint();
+    m_checkpoint.method = m_options.method;
+
+    switch (m_options.method) {
+    case Method::TrBdf2:
+        return solveTrBdf2(rhs, jacobian, initialConditions, startTime, endTime, trajectory);
+    case Method::BackwardEuler:
+        if (m_options.stepSize > 0.0)
+            return solveBackwardEuler(rhs, jacobian, initialConditions, startTime, endTime, trajectory);
+        break;
+    default:
+        break;
+    }
+    return finish({ SolveStatus::InvalidOptions, startTime }, initialConditions, 0.0);
+}
+
+template <int N>
+typename FixedSizeSolver<N>::State FixedSizeSolver<N>::errorScale(const State& y) const
+{
+    return (m_options.absTolerance + m_options.relTolerance * y.array().abs()).matrix();
+}
+
+template <int N>
+SolveResult FixedSizeSolver<N>::finish(const SolveResult& result, const State& y, double h) const
+{
+    m_checkpoint.t = result.stopTime;
+    m_checkpoint.y = y;
+    m_checkpoint.h = h;
+    count(m_statistics.acceptedSteps, result.acceptedSteps);
+    count(m_statistics.rejectedSteps, result.rejectedSteps);
+    return result;
+}
+
+template <int N>
+template <typename Rhs, typename Jacobian>
+SolveResult FixedSizeSolver<N>::solveBackwardEuler(const Rhs& rhs, const Jacobian& jacobian,
+                                                   const State& initialConditions, double startTime,
+                                                   double endTime, Trajectory& trajectory) const
+{
+    const double stepSize = m_options.stepSize;
+    size_t currentStep = 0;
+
+    const size_t steps = fixedStepCount(startTime, endTime, stepSize);
+    if (m_options.storeTrajectory)
+        trajectory.reserve(std::min(steps, m_options.maxSteps) + 1);
+
+    State y = initialConditions;
+    double t = startTime;
+    if (m_options.storeTrajectory)
+        trajectory.append(t, y.data());
+
+    Detail::FixedNewton<N, Rhs, Jacobian> newton(rhs, jacobian, m_options.maxNewtonIterations);
+
+    while (currentStep < steps) {
+        if (m_options.stopThreshold > 0.0 && (y.array().abs() <= m_options.stopThreshold).all())
+            return finish({ SolveStatus::BelowThreshold, t, currentStep }, y, stepSize);
+
+        if (currentStep >= m_options.maxSteps)
+            return finish({ SolveStatus::MaxStepsExceeded, t, currentStep }, y, stepSize);
+
+        const double tNext = fixedStepTime(startTime, endTime, stepSize, currentStep + 1);
+        const State scale = errorScale(y);
+        State yNext = y;
+        newton.prepare(t, y, stepSize);
+        if (!newton.solve(tNext, y, scale, yNext)) {
+            if (newton.jacobianCurrent())
+                return finish({ SolveStatus::NewtonFailure, t, currentStep }, y, stepSize);
+
+            yNext = y;
+            newton.prepare(t, y, stepSize);
+            if (!newton.solve(tNext, y, scale, yNext))
+                return finish({ SolveStatus::NewtonFailure, t, currentStep }, y, stepSize);
+        }
+
+        y = yNext;
+        t = tNext;
+        ++currentStep;
+        if (m_options.storeTrajectory)
+            trajectory.append(t, y.data());
+
+        if (m_progress && !m_progress(t))
+            return finish({ SolveStatus::Cancelled, t, currentStep }, y, stepSize);
+    }
+
+    return finish({ SolveStatus::Finished, t, currentStep }, y, stepSize);
+}
+
+template <int N>
+template <typename Rhs, typename Jacobian>
+SolveResult FixedSizeSolver<N>::solveTrBdf2(const Rhs& rhs, const Jacobian& jacobian, const State& initialConditions,
+                                            double startTime, double endTime, Trajectory& trajectory) const
+{
+    const double gamma = 2.0 - std::sqrt(2.0);
+    const double d = gamma / 2.0;
+    const double w = std::sqrt(2.0) / 4.0;
+    const double e1 = w - (1.0 - w) / 3.0;
+    const double e2 = w - (3.0 * w + 1.0) / 3.0;
+    const double e3 = 2.0 * d / 3.0;
+
+    const double safety = 0.9;
+    const double minFactor = 0.2;
+    const double maxFactor = 5.0;
+    const double keepStepFactor = 1.2;
+    // Как в StiffOdeSolver::solveTrBdf2: погрешность итераций входит в оценку погрешности шага
+    const double newtonTolerance = 0.003;
+
+    SolveResult result;
+    double t = startTime;
+    State y = initialConditions;
+    State f;
+    rhs(t, y, f);
+
+    if (m_options.storeTrajectory)
+        trajectory.append(t, y.data());
+
+    double h = m_options.stepSize;
+    if (h <= 0.0) {
+        const State scale = errorScale(y);
+        const double d0 = std::sqrt((y.array() / scale.array()).square().sum() / N);
+        const double d1 = std::sqrt((f.array() / scale.array()).square().sum() / N);
+        h = (d0 < 1e-5 || d1 < 1e-5) ? 1e-6 : 0.01 * d0 / d1;
+    }
+    bool rejectedLast = false;
+
+    Detail::FixedNewton<N, Rhs, Jacobian> newton(rhs, jacobian, m_options.maxNewtonIterations, newtonTolerance);
+
+    while (t < endTime) {
+        if (m_options.stopThreshold > 0.0 && (y.array().abs() <= m_options.stopThreshold).all())
+            return finish({ SolveStatus::BelowThreshold, t, result.acceptedSteps, result.rejectedSteps }, y, h);
+
+        if (result.acceptedSteps + result.rejectedSteps >= m_options.maxSteps)
+            return finish({ SolveStatus::MaxStepsExceeded, t, result.acceptedSteps, result.rejectedSteps }, y, h);
+
+        if (m_options.maxStepSize > 0.0)
+            h = std::min(h, m_options.maxStepSize);
+
+        const double remaining = endTime - t;
+        if (h >= remaining || remaining - h < m_options.minStepSize)
+            h = remaining;
+
+        if (h < m_options.minStepSize)
+            return finish({ SolveStatus::StepSizeTooSmall, t, result.acceptedSteps, result.rejectedSteps }, y, h);
+
+        newton.prepare(t, y, d * h);
+        const State scale = errorScale(y);
+
+        const State rhs2 = y + d * h * f;
+        State z2 = y;
+        bool converged = newton.solve(t + gamma * h, rhs2, scale, z2);
+
+        State k2;
+        State rhs3;
+        State z3;
+        if (converged) {
+            k2 = (z2 - rhs2) / (d * h);
+            rhs3 = y + w * h * (f + k2);
+            z3 = y + (z2 - y) / gamma;
+            converged = newton.solve(t + h, rhs3, scale, z3);
+        }
+
+        if (!converged) {
+            if (!newton.jacobianCurrent())
+                continue;
+
+            ++result.rejectedSteps;
+            rejectedLast = true;
+            h *= 0.25;
+            continue;
+        }
+
+        const State k3 = (z3 - rhs3) / (d * h);
+        const State error = newton.solveLinear(h * (e1 * f + e2 * k2 + e3 * k3));
+        const double norm = std::sqrt((error.array() / (m_options.absTolerance + m_options.relTolerance
+                                                        * y.array().abs().max(z3.array().abs())))
+                                          .square().sum() / N);
+
+        double factor = norm > 0.0 ? safety * std::pow(norm, -1.0 / 3.0) : maxFactor;
+        factor = std::clamp(factor, minFactor, rejectedLast ? 1.0 : maxFactor);
+        if (factor >= 1.0 && factor < keepStepFactor)
+            factor = 1.0;
+
+        if (norm <= 1.0) {
+            t = (h == remaining) ? endTime : t + h;
+            y = z3;
+            rhs(t, y, f);
+            if (m_options.storeTrajectory)
+                trajectory.append(t, y.data());
+            ++result.acceptedSteps;
+            rejectedLast = false;
+
+            if (m_progress && !m_progress(t))
+                return finish({ SolveStatus::Cancelled, t, result.acceptedSteps, result.rejectedSteps }, y, h);
+        }
+        else {
+            ++result.rejectedSteps;
+            rejectedLast = true;
+        }
+
+        h *= factor;
+    }
+
+    return finish({ SolveStatus::Finished, t, result.acceptedSteps, result.rejectedSteps }, y, h);
+}
+}
@@ -0,0 +1,242 @@
+#include "StiffOdeGlobalError.hpp"
+#include "StiffOdePropagator.hpp"
+
+#include <Eigen/Eigenvalues>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace StiffOde
+{
+namespace
+{
+// Предел числа обусловленности базиса собственных векторов, при котором спектральное
+// представление точного решения ещё не теряет точность заметно по сравнению с exp(A)
+const double maxEigenvectorCondition = 1e8;
+
+// Замена экстремума current, если value больше (greater) или меньше его; при равных значениях
+// берётся более ранний узел, так что результат не зависит от распределения блоков по потокам
+void updateExtremum(double value, double t, double& current, double& currentTime, bool greater)
+{
+    if ((greater ? value > current : value < current) || (value == current && t < currentTime)) {
+        current = value;
+        currentTime = t;
+    }
+}
+
+// Накопление статистики одной компоненты
+struct ErrorAccumulator
+{
+    double max = std::numeric_limits<double>::lowest();
+    double maxTime = 0.0;
+    double min = std::numeric_limits<double>::max();
+    double minTime = 0.0;
+    double maxAbs = -1.0;
+    double maxAbsTime = 0.0;
+    double sumSquares = 0.0;
+    size_t count = 0;
+
+    void merge(const ErrorAccumulator& other)
+    {
+        if (other.count == 0)
+            return;
+        updateExtremum(other.max, other.maxTime, max, maxTime, true);
+        updateExtremum(other.min, other.minTime, min, minTime, false);
+        updateExtremum(other.maxAbs, other.maxAbsTime, maxAbs, maxAbsTime, true);
+        sumSquares += other.sumSquares;
+        count += other.count;
+    }
+
+    ErrorStatistics statistics() const
+    {
+        ErrorStatistics result;
+        if (count == 0)
+            return result;
+        result.max = max;
+        result.maxTime = maxTime;
+        result.min = min;
+        result.minTime = minTime;
+        result.maxAbs = maxAbs;
+        result.maxAbsTime = maxAbsTime;
+        result.rms = std::sqrt(sumSquares / static_cast<double>(count));
+        result.count = count;
+        return result;
+    }
+};
+}
+
+bool GlobalError::empty() const
+{
+    return times.empty();
+}
+
+GlobalErrorKernel::GlobalErrorKernel(const Matrix& a, const Vector& initialConditions, double startTime)
+    : m_matrix(a),
+    m_initialConditions(initialConditions),
+    m_startTime(startTime)
+{
+    if (a.rows() == 0 || a.rows() != a.cols() || a.rows() != initialConditions.size())
+        return;
+
+    const Eigen::EigenSolver<Matrix> eigen(a);
+    if (eigen.info() != Eigen::Success || eigen.eigenvalues().imag().cwiseAbs().maxCoeff() != 0.0)
+        return;
+
+    const Matrix vectors = eigen.eigenvectors().real();
+    const Vector singularValues = Eigen::JacobiSVD<Matrix>(vectors).singularValues();
+    const double smallest = singularValues(singularValues.size() - 1);
+    if (!(smallest > 0.0) || singularValues(0) / smallest > maxEigenvectorCondition)
+        return;
+
+    m_eigenvalues = eigen.eigenvalues().real();
+    m_eigenvectors = vectors;
+    m_coefficients = vectors.fullPivLu().solve(initialConditions);
+    m_modal = true;
+}
+
+void GlobalErrorKernel::setThreadCount(size_t count)
+{
+    m_threadCount = count;
+}
+
+void GlobalErrorKernel::setBlockSize(size_t size)
+{
+    m_blockSize = std::max<size_t>(size, 1);
+}
+
+bool GlobalErrorKernel::isModal() const
+{
+    return m_modal;
+}
+
+GlobalError GlobalErrorKernel::evaluate(const DenseOutputFactory& numericalSolution, double gridStart,
+                                        double gridEnd, double stepSize, const std::atomic<bool>* cancel) const
+{
+    GlobalError result;
+    const Eigen::Index n = m_initialConditions.size();
+    const size_t count = gridPointCount(gridStart, gridEnd, stepSize);
+    if (n == 0 || m_matrix.rows() != n || count == 0 || !numericalSolution)
+        return result;
+
+    // Узлы сетки на отрезке численного решения: с first - первого не раньше начала, до end - следующего
+    // за последним не позже конца. Последний узел, совпадающий с концом сетки с точностью до округления,
+    // равен ему в точности и не отбрасывается
+    const DenseOutput probe = numericalSolution();
+    auto nodeTime = [gridStart, gridEnd, stepSize](size_t i)
+    {
+        return fixedStepTime(gridStart, gridEnd, stepSize, i);
+    };
+    size_t first = static_cast<size_t>(std::max(0.0, std::floor((probe.startTime() - gridStart) / stepSize)));
+    while (first < count && nodeTime(first) < probe.startTime())
+        ++first;
+    size_t end = count;
+    if (probe.endTime() < nodeTime(count - 1))
+        end = std::min(count, static_cast<size_t>(std::max(0.0, std::floor((probe.endTime() - gridStart)
+                                                                              / stepSize))) + 2);
+    while (end > first && nodeTime(end - 1) > probe.endTime())
+        --end;
+    if (first >= end)
+        return result;
+
+    const size_t points = end - first;
+    result.times.resize(points);
+    result.errors = Matrix::Zero(static_cast<Eigen::Index>(points), n);
+
+    const Matrix stepMatrix = m_modal ? Matrix() : matrixExponential(stepSize * m_matrix);
+    const size_t blockSize = m_blockSize;
+    const size_t blocks = (points + blockSize - 1) / blockSize;
+    const size_t hardwareThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    const size_t threads = std::min(m_threadCount > 0 ? m_threadCount : hardwareThreads, blocks);
+
+    std::atomic<size_t> nextBlock {0};
+    std::vector<std::vector<ErrorAccumulator>> accumulators(threads, std::vector<ErrorAccumulator>(n));
+
+    // Каждый поток получает своё непрерывное продолжение: оно хранит текущий интервал и рабочие векторы
+    auto worker = [&](size_t index)
+    {
+        DenseOutput solution = numericalSolution();
+        std::vector<ErrorAccumulator>& statistics = accumulators[index];
+        Matrix exact;
+        Matrix numerical(n, static_cast<Eigen::Index>(blockSize));
+
+        for (size_t b = nextBlock++; b < blocks; b = nextBlock++) {
+            if (cancel != nullptr && cancel->load(std::memory_order_relaxed))
+                return;
+
+            const size_t offset = b * blockSize;
+            const Eigen::Index rows = static_cast<Eigen::Index>(std::min(blockSize, points - offset));
+            double* times = result.times.data() + offset;
+            for (Eigen::Index i = 0; i < rows; ++i)
+                times[i] = nodeTime(first + offset + static_cast<size_t>(i));
+
+            exactBlock(times, rows, stepMatrix, exact);
+            for (Eigen::Index i = 0; i < rows; ++i)
+                solution.evaluate(times[i], numerical.col(i).data());
+
+            auto errors = result.errors.middleRows(static_cast<Eigen::Index>(offset), rows);
+            errors.noalias() = numerical.leftCols(rows).transpose() - exact;
+
+            for (Eigen::Index j = 0; j < n; ++j) {
+                const auto column = errors.col(j);
+                ErrorAccumulator& accumulator = statistics[static_cast<size_t>(j)];
+                Eigen::Index maxIndex = 0;
+                Eigen::Index minIndex = 0;
+                Eigen::Index maxAbsIndex = 0;
+                const double max = column.maxCoeff(&maxIndex);
+                const double min = column.minCoeff(&minIndex);
+                const double maxAbs = column.cwiseAbs().maxCoeff(&maxAbsIndex);
+                updateExtremum(max, times[maxIndex], accumulator.max, accumulator.maxTime, true);
+                updateExtremum(min, times[minIndex], accumulator.min, accumulator.minTime, false);
+                updateExtremum(maxAbs, times[maxAbsIndex], accumulator.maxAbs, accumulator.maxAbsTime, true);
+                accumulator.sumSquares += column.squaredNorm();
+                accumulator.count += static_cast<size_t>(rows);
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (size_t i = 1; i < threads; ++i)
+        pool.emplace_back(worker, i);
+    worker(0);
+    for (auto& thread : pool)
+        thread.join();
+
+    result.statistics.reserve(static_cast<size_t>(n));
+    for (Eigen::Index j = 0; j < n; ++j) {
+        ErrorAccumulator total;
+        for (size_t i = 0; i < threads; ++i)
+            total.merge(accumulators[i][static_cast<size_t>(j)]);
+        result.statistics.push_back(total.statistics());
+    }
+    return result;
+}
+
+// Точное решение в узлах блока: exact(i, j) = y_j(times[i])
+void GlobalErrorKernel::exactBlock(const double* times, Eigen::Index rows, const Matrix& stepMatrix,
+                                   Matrix& exact) const
+{
+    const Eigen::Index n = m_initialConditions.size();
+    exact.resize(rows, n);
+
+    if (m_modal) {
+        // Столбец k - вклад k-й моды c_k exp(λ_k (t - t0)); экспонента считается векторно по всему блоку
+        const Eigen::ArrayXd tau = Eigen::Map<const Eigen::ArrayXd>(times, rows) - m_startTime;
+        Matrix modes(rows, n);
+        for (Eigen::Index k = 0; k < n; ++k)
+            modes.col(k) = m_coefficients[k] * (m_eigenvalues[k] * tau).exp();
+        exact.noalias() = modes * m_eigenvectors.transpose();
+        return;
+    }
+
+    Vector y = matrixExponential((times[0] - m_startTime) * m_matrix) * m_initialConditions;
+    Vector yNext(n);
+    for (Eigen::Index i = 0; i < rows; ++i) {
+        exact.row(i) = y.transpose();
+        yNext.noalias() = stepMatrix * y;
+        y.swap(yNext);
+    }
+}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "StiffOdeDenseOutput.hpp"
+#include "StiffOdeTrajectory.hpp"
+#include "StiffOdeTypes.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace StiffOde
+{
+// Статистика глобальной погрешности одной компоненты по всем узлам
+struct ErrorStatistics
+{
+    double max = 0.0;
+    double maxTime = 0.0;
+    double min = 0.0;
+    double minTime = 0.0;
+    double maxAbs = 0.0;        // max |e| и момент, в котором он достигается
+    double maxAbsTime = 0.0;
+    double rms = 0.0;
+    size_t count = 0;
+};
+
+struct GlobalError
+{
+    std::vector<double> times;  // узлы сетки точного решения, попадающие на отрезок численного решения
+    Matrix errors;              // errors(i, j) - погрешность компоненты j в узле i; компоненты хранятся подряд
+    std::vector<ErrorStatistics> statistics;
+
+    bool empty() const;
+};
+
+// Создаёт непрерывное продолжение численного решения; вызывается по одному разу в каждом потоке
+using DenseOutputFactory = std::function<DenseOutput()>;
+
+// Глобальная погрешность решения линейной системы y' = A y за один проход по сетке. Сетка делится на блоки,
+// блоки обрабатываются параллельно; в блоке точное решение, погрешность и статистика считаются сразу,
+// без промежуточного вектора точного решения. Если A диагонализуема с вещественным спектром и хорошо
+// обусловленным базисом собственных векторов, y(t) = V exp(Λ (t - t0)) V^-1 y0 и экспоненты узлов блока
+// вычисляются векторными операциями Eigen над массивами; иначе первый узел блока получается через exp(A),
+// остальные - пропагатором exp(hA).
+class GlobalErrorKernel
+{
+public:
+    GlobalErrorKernel(const Matrix& a, const Vector& initialConditions, double startTime);
+
+    void setThreadCount(size_t count);      // 0 - по числу ядер
+    void setBlockSize(size_t size);
+    // true - используется спектральное представление точного решения
+    bool isModal() const;
+
+    // Узлы сетки fixedStepTime(gridStart, gridEnd, h, i), i < gridPointCount(), лежащие на отрезке численного
+    // решения: та же сетка, что у решателя с постоянным шагом. Выставленный cancel прерывает расчёт,
+    // необработанные узлы остаются нулевыми
+    GlobalError evaluate(const DenseOutputFactory& numericalSolution, double gridStart, double gridEnd,
+                         double stepSize, const std::atomic<bool>* cancel = nullptr) const;
+
+private:
+    void exactBlock(const double* times, Eigen::Index rows, const Matrix& stepMatrix, Matrix& exact) const;
+
+    Matrix m_matrix;
+    Vector m_initialConditions;
+    double m_startTime;
+    bool m_modal {false};
+    Vector m_eigenvalues;
+    Matrix m_eigenvectors;
+    Vector m_coefficients;      // V^-1 y0
+    size_t m_threadCount {0};
+    size_t m_blockSize {512};
+};
+}
@@ -0,0 +1,38 @@
+#include "StiffOdeGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace StiffOde
+{
+namespace
+{
+// Относительное отклонение конца отрезка от узла сетки, списываемое на округление
+const double gridTolerance = 1e-9;
+}
+
+size_t fixedStepCount(double startTime, double endTime, double stepSize)
+{
+    if (!(stepSize > 0.0) || !(endTime > startTime))
+        return 0;
+    const double ratio = (endTime - startTime) / stepSize;
+    const double nearest = std::round(ratio);
+    if (std::abs(ratio - nearest) <= gridTolerance * std::max(1.0, nearest))
+        return static_cast<size_t>(nearest);
+    return static_cast<size_t>(std::floor(ratio));
+}
+
+double fixedStepTime(double startTime, double endTime, double stepSize, size_t k)
+{
+    const double steps = static_cast<double>(k);
+    const double t = startTime + steps * stepSize;
+    return std::abs(t - endTime) <= gridTolerance * std::max(1.0, steps) * stepSize ? endTime : t;
+}
+
+size_t gridPointCount(double start, double end, double stepSize)
+{
+    if (!(stepSize > 0.0) || end < start)
+        return 0;
+    return fixedStepCount(start, end, stepSize) + 1;
+}
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+
+namespace StiffOde
+{
+// Равномерная сетка с шагом h: узлы start + k*h, k = 0..fixedStepCount(). Узел считается от начала, а не
+// суммированием шага, и конец отрезка, лежащий на сетке с точностью до округления, входит в неё как последний узел.
+// Одна и та же сетка у решателя с постоянным шагом и у точного решения, поэтому их узлы совпадают
+size_t fixedStepCount(double startTime, double endTime, double stepSize);
+double fixedStepTime(double startTime, double endTime, double stepSize, size_t k);
+
+// Число узлов той же сетки на [start, end]: fixedStepCount() + 1, 0 при h <= 0 или end < start
+size_t gridPointCount(double start, double end, double stepSize);
+}
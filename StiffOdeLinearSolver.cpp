@@ -0,0 +1,556 @@
+#include "StiffOdeLinearSolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace StiffOde
+{
+namespace
+{
+double perturbation(double y)
+{
+    static const double sqrtEps = std::sqrt(std::numeric_limits<double>::epsilon());
+    return sqrtEps * std::max(1e-5, std::abs(y));
+}
+
+// Шаблон ленточной матрицы (с диагональю) в формате CSC
+SparseMatrix bandPattern(Eigen::Index n, Eigen::Index lower, Eigen::Index upper)
+{
+    std::vector<Eigen::Triplet<double>> triplets;
+    for (Eigen::Index j = 0; j < n; ++j) {
+        for (Eigen::Index i = std::max<Eigen::Index>(0, j - upper); i <= std::min(n - 1, j + lower); ++i) {
+            triplets.emplace_back(i, j, 0.0);
+        }
+    }
+    SparseMatrix pattern(n, n);
+    pattern.setFromTriplets(triplets.begin(), triplets.end());
+    return pattern;
+}
+
+// Шаблон из заданных позиций; диагональ добавляется всегда, чтобы у (I - hGamma * J) была та же структура
+SparseMatrix declaredPattern(Eigen::Index n, const std::vector<std::pair<Eigen::Index, Eigen::Index>>& nonZeros)
+{
+    std::vector<Eigen::Triplet<double>> triplets;
+    triplets.reserve(nonZeros.size() + static_cast<size_t>(n));
+    for (const auto& [row, col] : nonZeros) {
+        triplets.emplace_back(row, col, 0.0);
+    }
+    for (Eigen::Index i = 0; i < n; ++i) {
+        triplets.emplace_back(i, i, 0.0);
+    }
+    SparseMatrix pattern(n, n);
+    pattern.setFromTriplets(triplets.begin(), triplets.end());
+    pattern.makeCompressed();
+    return pattern;
+}
+
+// Рабочие массивы конечно-разностного Якобиана, выделяемые один раз
+struct DifferenceBuffers
+{
+    explicit DifferenceBuffers(Eigen::Index size)
+        : f(size), fPerturbed(size), yPerturbed(size)
+    {
+    }
+
+    Vector f;
+    Vector fPerturbed;
+    Vector yPerturbed;
+};
+
+// Конечно-разностный Якобиан по раскраске: значения записываются в ненулевые позиции pattern
+void coloredFiniteDifferences(const InPlaceSystem& system, double t, const Vector& y,
+                              const std::vector<std::vector<Eigen::Index>>& groups, SparseMatrix& jacobian,
+                              DifferenceBuffers& buffers)
+{
+    const Vector& f = buffers.f;
+    const Vector& fPerturbed = buffers.fPerturbed;
+    Vector& yPerturbed = buffers.yPerturbed;
+
+    evaluate(system, t, y, buffers.f);
+    yPerturbed = y;
+
+    for (const auto& group : groups) {
+        for (Eigen::Index j : group) {
+            yPerturbed[j] = y[j] + perturbation(y[j]);
+        }
+
+        evaluate(system, t, yPerturbed, buffers.fPerturbed);
+
+        for (Eigen::Index j : group) {
+            const double delta = yPerturbed[j] - y[j];
+            for (SparseMatrix::InnerIterator it(jacobian, j); it; ++it) {
+                it.valueRef() = (fPerturbed[it.row()] - f[it.row()]) / delta;
+            }
+            yPerturbed[j] = y[j];
+        }
+    }
+}
+
+class DenseLinearSolver : public LinearSolver
+{
+public:
+    DenseLinearSolver(const InPlaceSystem& system, const JacobianFunction& jacobian,
+                      const SparseJacobianFunction& sparseJacobian, Eigen::Index size)
+        : m_system(system), m_jacobianFunction(jacobian), m_sparseJacobianFunction(sparseJacobian),
+        m_jacobian(Matrix::Zero(size, size)), m_lu(size), m_buffers(size)
+    {
+    }
+
+    void evaluateJacobian(double t, const Vector& y) override
+    {
+        // Интерфейс Якобиана пользователя принимает std::vector; разностный Якобиан обходится без выделений
+        if (m_jacobianFunction) {
+            m_jacobian = m_jacobianFunction(std::vector<double>(y.data(), y.data() + y.size()), t);
+            return;
+        }
+        if (m_sparseJacobianFunction) {
+            m_jacobian = Matrix(m_sparseJacobianFunction(std::vector<double>(y.data(), y.data() + y.size()), t));
+            return;
+        }
+
+        // Якобиан конечными разностями по столбцам
+        Vector& yPerturbed = m_buffers.yPerturbed;
+        evaluate(m_system, t, y, m_buffers.f);
+        yPerturbed = y;
+        for (Eigen::Index j = 0; j < y.size(); ++j) {
+            const double delta = perturbation(y[j]);
+            yPerturbed[j] = y[j] + delta;
+            evaluate(m_system, t, yPerturbed, m_buffers.fPerturbed);
+            m_jacobian.col(j) = (m_buffers.fPerturbed - m_buffers.f) / delta;
+            yPerturbed[j] = y[j];
+        }
+    }
+
+    void factorize(double hGamma) override
+    {
+        m_lu.compute(Matrix::Identity(m_jacobian.rows(), m_jacobian.cols()) - hGamma * m_jacobian);
+    }
+
+    void solve(const Vector& b, Vector& x) const override
+    {
+        x.noalias() = m_lu.solve(b);
+    }
+
+    void factorizeComplex(std::complex<double> hGamma) override
+    {
+        m_complexLu.compute(ComplexMatrix::Identity(m_jacobian.rows(), m_jacobian.cols())
+                            - hGamma * m_jacobian.cast<std::complex<double>>());
+    }
+
+    void solveComplex(const ComplexVector& b, ComplexVector& x) const override
+    {
+        x.noalias() = m_complexLu.solve(b);
+    }
+
+    void multiply(const Vector& v, Vector& result) const override
+    {
+        result.noalias() = m_jacobian * v;
+    }
+
+    void denseJacobian(Matrix& jacobian) const override
+    {
+        jacobian = m_jacobian;
+    }
+
+private:
+    const InPlaceSystem& m_system;
+    const JacobianFunction& m_jacobianFunction;
+    const SparseJacobianFunction& m_sparseJacobianFunction;
+    Matrix m_jacobian;
+    Eigen::PartialPivLU<Matrix> m_lu;
+    Eigen::PartialPivLU<ComplexMatrix> m_complexLu;
+    DifferenceBuffers m_buffers;
+};
+
+// Ленточное LU с частичным выбором в духе LAPACK dgbtrf/zgbtrf: элемент (i, j) хранится в
+// m_factors[j * m_leading + kv + i - j], где kv = ku + kl - место под заполнение от перестановок.
+// Память под множители выделяется при первом разложении.
+template <typename Scalar>
+class BandFactorization
+{
+public:
+    using VectorType = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+
+    BandFactorization(Eigen::Index size, Eigen::Index lower, Eigen::Index upper)
+        : m_size(size), m_lower(lower), m_upper(upper), m_leading(2 * lower + upper + 1)
+    {
+    }
+
+    // Разложение (I - hGamma * J) для J с ленточным шаблоном jacobian
+    void factorize(const SparseMatrix& jacobian, Scalar hGamma)
+    {
+        const Eigen::Index kv = m_upper + m_lower;
+        if (m_factors.empty()) {
+            m_factors.resize(static_cast<size_t>(m_size * m_leading));
+            m_pivots.resize(static_cast<size_t>(m_size));
+        }
+        std::fill(m_factors.begin(), m_factors.end(), Scalar(0.0));
+
+        for (Eigen::Index j = 0; j < m_size; ++j) {
+            for (SparseMatrix::InnerIterator it(jacobian, j); it; ++it) {
+                at(it.row(), j) = Scalar(it.row() == j ? 1.0 : 0.0) - hGamma * it.value();
+            }
+        }
+
+        for (Eigen::Index j = 0; j < m_size; ++j) {
+            const Eigen::Index last = std::min(m_size - 1, j + m_lower);
+            const Eigen::Index lastColumn = std::min(m_size - 1, j + kv);
+
+            Eigen::Index pivot = j;
+            for (Eigen::Index i = j + 1; i <= last; ++i) {
+                if (std::abs(at(i, j)) > std::abs(at(pivot, j)))
+                    pivot = i;
+            }
+            m_pivots[static_cast<size_t>(j)] = pivot;
+
+            if (pivot != j) {
+                for (Eigen::Index c = j; c <= lastColumn; ++c) {
+                    std::swap(at(j, c), at(pivot, c));
+                }
+            }
+
+            const Scalar diagonal = at(j, j);
+            if (diagonal == Scalar(0.0))
+                continue;
+
+            for (Eigen::Index i = j + 1; i <= last; ++i) {
+                at(i, j) /= diagonal;
+            }
+
+            for (Eigen::Index c = j + 1; c <= lastColumn; ++c) {
+                const Scalar u = at(j, c);
+                if (u == Scalar(0.0))
+                    continue;
+                for (Eigen::Index i = j + 1; i <= last; ++i) {
+                    at(i, c) -= at(i, j) * u;
+                }
+            }
+        }
+    }
+
+    void solve(const VectorType& b, VectorType& x) const
+    {
+        const Eigen::Index kv = m_upper + m_lower;
+        x = b;
+
+        for (Eigen::Index j = 0; j < m_size; ++j) {
+            const Eigen::Index pivot = m_pivots[static_cast<size_t>(j)];
+            if (pivot != j)
+                std::swap(x[j], x[pivot]);
+
+            const Eigen::Index last = std::min(m_size - 1, j + m_lower);
+            for (Eigen::Index i = j + 1; i <= last; ++i) {
+                x[i] -= at(i, j) * x[j];
+            }
+        }
+
+        for (Eigen::Index j = m_size - 1; j >= 0; --j) {
+            x[j] /= at(j, j);
+            for (Eigen::Index i = std::max<Eigen::Index>(0, j - kv); i < j; ++i) {
+                x[i] -= at(i, j) * x[j];
+            }
+        }
+    }
+
+private:
+    Scalar& at(Eigen::Index i, Eigen::Index j)
+    {
+        return m_factors[static_cast<size_t>(j * m_leading + m_upper + m_lower + i - j)];
+    }
+
+    const Scalar& at(Eigen::Index i, Eigen::Index j) const
+    {
+        return m_factors[static_cast<size_t>(j * m_leading + m_upper + m_lower + i - j)];
+    }
+
+    Eigen::Index m_size;
+    Eigen::Index m_lower;
+    Eigen::Index m_upper;
+    Eigen::Index m_leading;
+    std::vector<Scalar> m_factors;
+    std::vector<Eigen::Index> m_pivots;
+};
+
+class BandedLinearSolver : public LinearSolver
+{
+public:
+    BandedLinearSolver(const InPlaceSystem& system, const JacobianFunction& jacobian,
+                       const SparseJacobianFunction& sparseJacobian,
+                       Eigen::Index size, Eigen::Index lower, Eigen::Index upper)
+        : m_system(system), m_jacobianFunction(jacobian), m_sparseJacobianFunction(sparseJacobian),
+        m_size(size),
+        m_jacobian(bandPattern(size, lower, upper)),
+        m_groups(colorColumns(m_jacobian)),
+        m_factorization(size, lower, upper),
+        m_complexFactorization(size, lower, upper),
+        m_buffers(size)
+    {
+    }
+
+    void evaluateJacobian(double t, const Vector& y) override
+    {
+        if (m_jacobianFunction) {
+            const Matrix jacobian = m_jacobianFunction(std::vector<double>(y.data(), y.data() + y.size()), t);
+            for (Eigen::Index j = 0; j < m_size; ++j) {
+                for (SparseMatrix::InnerIterator it(m_jacobian, j); it; ++it) {
+                    it.valueRef() = jacobian(it.row(), j);
+                }
+            }
+            return;
+        }
+        if (m_sparseJacobianFunction) {
+            const SparseMatrix jacobian = m_sparseJacobianFunction(std::vector<double>(y.data(), y.data() + y.size()), t);
+            for (Eigen::Index j = 0; j < m_size; ++j) {
+                for (SparseMatrix::InnerIterator it(m_jacobian, j); it; ++it) {
+                    it.valueRef() = jacobian.coeff(it.row(), j);
+                }
+            }
+            return;
+        }
+
+        coloredFiniteDifferences(m_system, t, y, m_groups, m_jacobian, m_buffers);
+    }
+
+    void factorize(double hGamma) override
+    {
+        m_factorization.factorize(m_jacobian, hGamma);
+    }
+
+    void solve(const Vector& b, Vector& x) const override
+    {
+        m_factorization.solve(b, x);
+    }
+
+    void factorizeComplex(std::complex<double> hGamma) override
+    {
+        m_complexFactorization.factorize(m_jacobian, hGamma);
+    }
+
+    void solveComplex(const ComplexVector& b, ComplexVector& x) const override
+    {
+        m_complexFactorization.solve(b, x);
+    }
+
+    void multiply(const Vector& v, Vector& result) const override
+    {
+        result.noalias() = m_jacobian * v;
+    }
+
+    void denseJacobian(Matrix& jacobian) const override
+    {
+        jacobian = Matrix(m_jacobian);
+    }
+
+private:
+    const InPlaceSystem& m_system;
+    const JacobianFunction& m_jacobianFunction;
+    const SparseJacobianFunction& m_sparseJacobianFunction;
+    Eigen::Index m_size;
+    SparseMatrix m_jacobian;
+    std::vector<std::vector<Eigen::Index>> m_groups;
+    BandFactorization<double> m_factorization;
+    BandFactorization<std::complex<double>> m_complexFactorization;
+    DifferenceBuffers m_buffers;
+};
+
+// Структура сжатой разреженной матрицы, для которой выполнен символьный анализ SparseLU
+class AnalyzedPattern
+{
+public:
+    // true, если структура matrix отличается от запомненной (или её ещё нет); тогда запоминается новая
+    template <typename Scalar>
+    bool update(const Eigen::SparseMatrix<Scalar>& matrix)
+    {
+        const auto* outer = matrix.outerIndexPtr();
+        const auto* inner = matrix.innerIndexPtr();
+        const size_t outerSize = static_cast<size_t>(matrix.outerSize()) + 1;
+        const size_t nonZeros = static_cast<size_t>(matrix.nonZeros());
+        if (m_outer.size() == outerSize && m_inner.size() == nonZeros
+            && std::equal(m_outer.begin(), m_outer.end(), outer) && std::equal(m_inner.begin(), m_inner.end(), inner))
+            return false;
+
+        m_outer.assign(outer, outer + outerSize);
+        m_inner.assign(inner, inner + nonZeros);
+        return true;
+    }
+
+private:
+    std::vector<SparseMatrix::StorageIndex> m_outer;
+    std::vector<SparseMatrix::StorageIndex> m_inner;
+};
+
+class SparseLinearSolver : public LinearSolver
+{
+public:
+
+    SparseLinearSolver(const InPlaceSystem& system, const JacobianFunction& jacobian,
+                       const SparseJacobianFunction& sparseJacobian,
+                       const JacobianStructure& structure, Eigen::Index size)
+        : m_system(system), m_jacobianFunction(jacobian), m_sparseJacobianFunction(sparseJacobian),
+        m_identity(size, size), m_buffers(size)
+    {
+        m_identity.setIdentity();
+
+        // Без объявленной структуры она берётся из первого вычисления разреженного Якобиана
+        // (createLinearSolver() выбирает этот класс только при одном из двух условий).
+        // Раскраска нужна только конечно-разностному Якобиану
+        if (!structure.nonZeros.empty())
+            m_jacobian = declaredPattern(size, structure.nonZeros);
+        else
+            m_jacobian.resize(size, size);
+        if (!m_sparseJacobianFunction && !m_jacobianFunction)
+            m_groups = colorColumns(m_jacobian);
+    }
+
+    void evaluateJacobian(double t, const Vector& y) override
+    {
+        if (m_sparseJacobianFunction) {
+            m_jacobian = m_sparseJacobianFunction(std::vector<double>(y.data(), y.data() + y.size()), t);
+            return;
+        }
+        if (m_jacobianFunction) {
+            m_jacobian = m_jacobianFunction(std::vector<double>(y.data(), y.data() + y.size()), t).sparseView();
+            return;
+        }
+
+        coloredFiniteDifferences(m_system, t, y, m_groups, m_jacobian, m_buffers);
+    }
+
+    void factorize(double hGamma) override
+    {
+        m_matrix = m_identity - hGamma * m_jacobian;
+        m_matrix.makeCompressed();
+
+        // Символьный анализ зависит только от структуры и повторяется, когда пользовательский Якобиан её меняет
+        if (m_analyzedPattern.update(m_matrix))
+            m_lu.analyzePattern(m_matrix);
+        m_lu.factorize(m_matrix);
+    }
+
+    void solve(const Vector& b, Vector& x) const override
+    {
+        x = m_lu.solve(b);
+    }
+
+    void factorizeComplex(std::complex<double> hGamma) override
+    {
+        m_complexMatrix = m_identity.cast<std::complex<double>>() - hGamma * m_jacobian.cast<std::complex<double>>();
+        m_complexMatrix.makeCompressed();
+
+        if (m_complexAnalyzedPattern.update(m_complexMatrix))
+            m_complexLu.analyzePattern(m_complexMatrix);
+        m_complexLu.factorize(m_complexMatrix);
+    }
+
+    void solveComplex(const ComplexVector& b, ComplexVector& x) const override
+    {
+        x = m_complexLu.solve(b);
+    }
+
+    void multiply(const Vector& v, Vector& result) const override
+    {
+        result.noalias() = m_jacobian * v;
+    }
+
+    void denseJacobian(Matrix& jacobian) const override
+    {
+        jacobian = Matrix(m_jacobian);
+    }
+
+private:
+    using ComplexSparseMatrix = Eigen::SparseMatrix<std::complex<double>>;
+
+    const InPlaceSystem& m_system;
+    const JacobianFunction& m_jacobianFunction;
+    const SparseJacobianFunction& m_sparseJacobianFunction;
+    SparseMatrix m_identity;
+    SparseMatrix m_jacobian;
+    SparseMatrix m_matrix;
+    std::vector<std::vector<Eigen::Index>> m_groups;
+    Eigen::SparseLU<SparseMatrix, Eigen::COLAMDOrdering<int>> m_lu;
+    AnalyzedPattern m_analyzedPattern;
+    ComplexSparseMatrix m_complexMatrix;
+    Eigen::SparseLU<ComplexSparseMatrix, Eigen::COLAMDOrdering<int>> m_complexLu;
+    AnalyzedPattern m_complexAnalyzedPattern;
+    DifferenceBuffers m_buffers;
+};
+}
+
+void evaluate(const InPlaceSystem& system, double t, const Vector& y, Vector& f)
+{
+    system(t, y.data(), f.data());
+}
+
+InPlaceSystem inPlaceSystem(const System& system, size_t size)
+{
+    if (!system)
+        return {};
+
+    return [system, size](double t, const double* y, double* dydt)
+    {
+        const std::vector<double> f = system(std::vector<double>(y, y + size), t);
+        std::copy(f.begin(), f.end(), dydt);
+    };
+}
+
+std::vector<std::vector<Eigen::Index>> colorColumns(const SparseMatrix& pattern)
+{
+    const Eigen::Index n = pattern.cols();
+
+    // Для каждой строки - список столбцов с ненулевым элементом в ней
+    std::vector<std::vector<Eigen::Index>> rowColumns(static_cast<size_t>(pattern.rows()));
+    for (Eigen::Index j = 0; j < n; ++j) {
+        for (SparseMatrix::InnerIterator it(pattern, j); it; ++it) {
+            rowColumns[static_cast<size_t>(it.row())].push_back(j);
+        }
+    }
+
+    std::vector<Eigen::Index> colors(static_cast<size_t>(n), -1);
+    std::vector<Eigen::Index> forbiddenBy;
+    std::vector<std::vector<Eigen::Index>> groups;
+
+    for (Eigen::Index j = 0; j < n; ++j) {
+        for (SparseMatrix::InnerIterator it(pattern, j); it; ++it) {
+            for (Eigen::Index k : rowColumns[static_cast<size_t>(it.row())]) {
+                const Eigen::Index color = colors[static_cast<size_t>(k)];
+                if (color >= 0)
+                    forbiddenBy[static_cast<size_t>(color)] = j;
+            }
+        }
+
+        Eigen::Index color = 0;
+        while (color < static_cast<Eigen::Index>(groups.size()) && forbiddenBy[static_cast<size_t>(color)] == j) {
+            ++color;
+        }
+        if (color == static_cast<Eigen::Index>(groups.size())) {
+            groups.emplace_back();
+            forbiddenBy.push_back(-1);
+        }
+
+        colors[static_cast<size_t>(j)] = color;
+        groups[static_cast<size_t>(color)].push_back(j);
+    }
+
+    return groups;
+}
+
+std::unique_ptr<LinearSolver> createLinearSolver(const InPlaceSystem& system, const JacobianFunction& jacobian,
+                                                 const SparseJacobianFunction& sparseJacobian,
+                                                 const JacobianStructure& structure, Eigen::Index size)
+{
+    switch (structure.type) {
+    case LinearSolverType::Banded:
+        return std::make_unique<BandedLinearSolver>(system, jacobian, sparseJacobian, size,
+                                                    structure.lowerBandwidth, structure.upperBandwidth);
+    case LinearSolverType::Sparse:
+        // Без структуры и разреженного Якобиана "разреженная" матрица была бы заполненной
+        if (!structure.nonZeros.empty() || sparseJacobian)
+            return std::make_unique<SparseLinearSolver>(system, jacobian, sparseJacobian, structure, size);
+        break;
+    case LinearSolverType::Dense:
+        break;
+    }
+    return std::make_unique<DenseLinearSolver>(system, jacobian, sparseJacobian, size);
+}
+}
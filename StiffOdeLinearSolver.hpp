@@ -0,0 +1,65 @@
+#pragma once
+
+#include "StiffOdeTypes.hpp"
+
+#include <complex>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace StiffOde
+{
+enum class LinearSolverType
+{
+    Dense,  // плотное LU с частичным выбором
+    Banded, // ленточное LU с частичным выбором
+    Sparse  // Eigen::SparseLU
+};
+
+// Структура Якобиана: тип хранения, ширина ленты и (для разреженного случая) позиции ненулевых элементов.
+// По структуре столбцы раскрашиваются так, чтобы конечно-разностный Якобиан требовал по одному
+// вычислению правой части на цвет, а не на столбец. Разреженному хранению без nonZeros нужен
+// SparseJacobianFunction, структура которого и используется; без него решается плотным LU.
+struct JacobianStructure
+{
+    LinearSolverType type = LinearSolverType::Dense;
+    Eigen::Index lowerBandwidth = 0;
+    Eigen::Index upperBandwidth = 0;
+    std::vector<std::pair<Eigen::Index, Eigen::Index>> nonZeros; // (строка, столбец)
+};
+
+// Хранит Якобиан J и разложение матрицы (I - hGamma * J) неявной стадии.
+// Плотная и ленточная реализации не выделяют память после создания (кроме вызова пользовательского Якобиана
+// и первого комплексного разложения).
+class LinearSolver
+{
+public:
+    virtual ~LinearSolver() = default;
+
+    virtual void evaluateJacobian(double t, const Vector& y) = 0;
+    virtual void factorize(double hGamma) = 0;
+    // x должен иметь размер системы и не совпадать с b
+    virtual void solve(const Vector& b, Vector& x) const = 0;
+
+    // Разложение (I - hGamma * J) с комплексным hGamma для пары комплексных собственных значений
+    // матрицы метода Radau IIA; хранится отдельно от вещественного, и оба действуют одновременно
+    virtual void factorizeComplex(std::complex<double> hGamma) = 0;
+    virtual void solveComplex(const ComplexVector& b, ComplexVector& x) const = 0;
+
+    // Действие последнего вычисленного Якобиана для экспоненциальных методов: J v и J целиком
+    virtual void multiply(const Vector& v, Vector& result) const = 0;
+    virtual void denseJacobian(Matrix& jacobian) const = 0;
+};
+
+void evaluate(const InPlaceSystem& system, double t, const Vector& y, Vector& f);
+// Переходник от System к InPlaceSystem (с выделением памяти на каждый вызов)
+InPlaceSystem inPlaceSystem(const System& system, size_t size);
+
+std::unique_ptr<LinearSolver> createLinearSolver(const InPlaceSystem& system, const JacobianFunction& jacobian,
+                                                 const SparseJacobianFunction& sparseJacobian,
+                                                 const JacobianStructure& structure, Eigen::Index size);
+
+// Жадная раскраска столбцов: столбцы одного цвета не имеют общих ненулевых строк
+std::vector<std::vector<Eigen::Index>> colorColumns(const SparseMatrix& pattern);
+}
@@ -1,7 +1,12 @@
 #include "StiffOdeModel.hpp"
+#include "StiffOdeCheckpointFile.hpp"
+#include "StiffOdeFixedSolver.hpp"
+#include "StiffOdePropagator.hpp"
+#include <QFile>
 #include <QObject>
-#include <QtCharts/QLineSeries>
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <vector>
 #include <QDebug>
 #include <functional>
@@ -9,28 +14,126 @@
 
 namespace StiffOde
 {
+namespace
+{
+std::string filePath(const QString& path)
+{
+    return QFile::encodeName(path).toStdString();
+}
+
+// Наибольшая размерность, для которой FixedSizeSolver инстанцируется
+constexpr Eigen::Index maxFixedSize = 8;
+
+template <int N>
+SolveResult solveLinearFixedSize(const Matrix& a, const SolverOptions& options, const ProgressCallback& progress,
+                                 const std::vector<double>& initialConditions, double startTime, double endTime,
+                                 Trajectory& trajectory, SolverCheckpoint& checkpoint, SolverStatistics& statistics)
+{
+    using Solver = FixedSizeSolver<N>;
+    using State = typename Solver::State;
+    using JacobianMatrix = typename Solver::JacobianMatrix;
+
+    const JacobianMatrix matrix = a;
+    const auto rhs = [&matrix](double, const State& y, State& dydt) { dydt.noalias() = matrix * y; };
+    const auto jacobian = [&matrix](double, const State&, JacobianMatrix& j) { j = matrix; };
+
+    Solver solver;
+    solver.setOptions(options);
+    solver.setProgressCallback(progress);
+    const SolveResult result = solver.solve(rhs, jacobian, Eigen::Map<const State>(initialConditions.data()),
+                                            startTime, endTime, trajectory);
+    checkpoint = solver.checkpoint();
+    statistics = solver.statistics();
+    return result;
+}
+}
+
 StiffOdeModel::StiffOdeModel(QObject* parent)
     : QObject(parent), m_startTime(0.0), m_endTime(0.0), m_stepSize(0.1)
 {
-    m_system = [](const std::vector<double>& y, double t) -> std::vector<double>
+    Matrix A(2, 2);
+    A << -500.005, 499.995,
+        499.995, -500.005;
+    setLinearSystem(A);
+}
+
+void StiffOdeModel::setSystem(const System& system, const JacobianFunction& jacobian)
+{
+    m_solver.setSystem(system);
+    m_solver.setJacobian(jacobian);
+    m_linearMatrix.resize(0, 0);
+    clearSensitivities();
+    updateLinearSolution();
+    invalidateCache();
+}
+
+void StiffOdeModel::setInPlaceSystem(const InPlaceSystem& system, const JacobianFunction& jacobian)
+{
+    m_solver.setInPlaceSystem(system);
+    m_solver.setJacobian(jacobian);
+    m_linearMatrix.resize(0, 0);
+    clearSensitivities();
+    updateLinearSolution();
+    invalidateCache();
+}
+
+void StiffOdeModel::setLinearSystem(const Matrix& matrix)
+{
+    const Eigen::Index n = matrix.rows();
+    m_solver.setInPlaceSystem([matrix, n](double, const double* y, double* dydt)
     {
-        return
-            {
-                -500.005 * y[0] + 499.995 * y[1],
-                499.995 * y[0] - 500.005 * y[1]
-            };
-    };
+        Eigen::Map<Vector>(dydt, n).noalias() = matrix * Eigen::Map<const Vector>(y, n);
+    });
+    m_solver.setJacobian([matrix](const std::vector<double>&, double) -> Matrix
+    {
+        return matrix;
+    });
+    // Чувствительности к элементам прежней матрицы другой размерности теряют смысл
+    if (m_linearMatrix.rows() != n)
+        clearSensitivities();
+    m_linearMatrix = matrix;
+    updateLinearSolution();
+    invalidateCache();
+}
+
+bool StiffOdeModel::setLinearSensitivities(const std::vector<std::pair<Eigen::Index, Eigen::Index>>& entries)
+{
+    const Eigen::Index n = m_linearMatrix.rows();
+    for (const auto& entry : entries)
+        if (entry.first < 0 || entry.first >= n || entry.second < 0 || entry.second >= n)
+            return false;
+    if (entries.empty() || n == 0) {
+        clearSensitivities();
+        return entries.empty();
+    }
+
+    // df_i/da_ij = y_j, остальные производные по a_ij равны нулю
+    const Eigen::Index p = static_cast<Eigen::Index>(entries.size());
+    m_solver.setSensitivities([entries, n, p](double, const double* y) -> Matrix
+    {
+        Matrix derivatives = Matrix::Zero(n, p);
+        for (Eigen::Index k = 0; k < p; ++k)
+            derivatives(entries[static_cast<size_t>(k)].first, k) = y[entries[static_cast<size_t>(k)].second];
+        return derivatives;
+    }, Matrix::Zero(n, p));
+    m_sensitivityEntries = entries;
+    m_sensitivities.reset(0);
+    return true;
 }
 
-void StiffOdeModel::setSystem(const std::function<std::vector<double>(const std::vector<double>&, double)>& system)
+void StiffOdeModel::clearSensitivities()
 {
-    m_system = system;
+    m_solver.setSensitivities({}, Matrix());
+    m_sensitivityEntries.clear();
+    m_sensitivities.reset(0);
 }
 
 void StiffOdeModel::setInitialConditions(const std::vector<double>& initialConditions, double startTime)
 {
     m_initialConditions = initialConditions;
     m_startTime = startTime;
+    updateLinearSolution();
+    invalidateCache();
 }
 
 void StiffOdeModel::setParameters(double stepSize, double endTime, double endExactTime, double startExactTime)
@@ -39,152 +142,540 @@ void StiffOdeModel::setParameters(double stepSize, double endTime, double endExa
     m_endTime = endTime;
     m_endExactTime = endExactTime;
     m_startExactTime = startExactTime;
+    invalidateCache();
 }
 
-std::vector<QPointF> StiffOdeModel::computeExactSolution() const
+void StiffOdeModel::setMethod(Method method, double relTolerance, double absTolerance)
 {
-    Eigen::Matrix2d A;
-    A << -500.005, 499.995,
-        499.995, -500.005;
+    SolverOptions options = m_solver.options();
+    options.method = method;
+    options.relTolerance = relTolerance;
+    options.absTolerance = absTolerance;
+    m_solver.setOptions(options);
+}
 
-    Eigen::EigenSolver<Eigen::Matrix2d> solver(A);
-    Eigen::Vector2d eigenValues = solver.eigenvalues().real();
-    Eigen::Matrix2d eigenVectors = solver.eigenvectors().real();
+void StiffOdeModel::setEvents(const std::vector<Event>& events)
+{
+    m_solver.setEvents(events);
+}
 
-    Eigen::Vector2d initialConditions(m_initialConditions[0], m_initialConditions[1]);
-    Eigen::Vector2d coefficients = eigenVectors.inverse() * initialConditions;
+void StiffOdeModel::invalidateCache()
+{
+    m_globalErrorValid = false;
+    m_globalError = GlobalError();
+}
 
-    std::vector<QPointF> exactSolution;
-    double t = m_startExactTime;
+void StiffOdeModel::updateLinearSolution()
+{
+    const Eigen::Index n = static_cast<Eigen::Index>(m_initialConditions.size());
+    if (n == 0 || m_linearMatrix.rows() != n) {
+        m_linearSolution.reset();
+        return;
+    }
+    m_linearSolution.emplace(m_linearMatrix, Eigen::Map<const Vector>(m_initialConditions.data(), n), m_startTime);
+}
 
-    const double threshold = 1e-15;
+const GlobalError& StiffOdeModel::computeGlobalError() const
+{
+    if (!m_globalErrorValid) {
+        m_statistics.phases.globalErrorSeconds = 0.0;
+        ScopedTimer timer(m_statistics.phases.globalErrorSeconds);
+        m_globalError = evaluateGlobalError();
+        m_globalErrorValid = true;
+    }
+    return m_globalError;
+}
 
-    while (t <= m_endExactTime)
-    {
-        Eigen::Vector2d solution = coefficients[0] * exp(eigenValues[0] * t) * eigenVectors.col(0) +
-                                   coefficients[1] * exp(eigenValues[1] * t) * eigenVectors.col(1);
+GlobalError StiffOdeModel::evaluateGlobalError() const
+{
+    const auto& numericalSolution = getTrajectoryData();
+    const Eigen::Index n = static_cast<Eigen::Index>(m_initialConditions.size());
+    if (numericalSolution.empty() || n == 0 || m_linearMatrix.rows() != n)
+        return {};
 
-        double y0 = (std::abs(solution[0]) < threshold) ? 0.0 : solution[0];
-        double y1 = (std::abs(solution[1]) < threshold) ? 0.0 : solution[1];
+    // Точное решение в узлах сетки считается ядром вместе с погрешностью и не хранится; численное - через
+    // непрерывное продолжение, поэтому сравниваются значения в одной и той же точке при любых шагах
+    // и начальных моментах
+    const GlobalErrorKernel kernel(m_linearMatrix, Eigen::Map<const Vector>(m_initialConditions.data(), n),
+                                   m_startTime);
+    return kernel.evaluate([this, &numericalSolution]() { return m_solver.denseOutput(numericalSolution); },
+                           m_startExactTime, m_endExactTime, m_stepSize, &m_cancelRequested);
+}
 
-        exactSolution.emplace_back(t, y0);
-        exactSolution.emplace_back(t, y1);
+bool StiffOdeModel::exactSolutionAt(double t, double* y) const
+{
+    // Разложение A считается один раз при смене задачи, а не exp((t - t0) A) в каждой точке
+    if (!m_linearSolution)
+        return false;
+    m_linearSolution->evaluate(t, y);
+    return true;
+}
 
-        t += m_stepSize;
-    }
+double StiffOdeModel::exactComponentAt(double t, size_t component) const
+{
+    if (!m_linearSolution || component >= m_initialConditions.size())
+        return 0.0;
+    return m_linearSolution->component(t, static_cast<Eigen::Index>(component));
+}
 
-    return exactSolution;
+size_t StiffOdeModel::exactGridSize() const
+{
+    const Eigen::Index n = static_cast<Eigen::Index>(m_initialConditions.size());
+    if (n == 0 || m_linearMatrix.rows() != n)
+        return 0;
+    return gridPointCount(m_startExactTime, m_endExactTime, m_stepSize);
 }
 
+double StiffOdeModel::exactGridTime(size_t i) const
+{
+    return fixedStepTime(m_startExactTime, m_endExactTime, m_stepSize, i);
+}
 
-std::vector<std::vector<QPointF>> StiffOdeModel::computeGlobalError() const
+size_t StiffOdeModel::numComponents() const
 {
-    const auto exactSolution = computeExactSolution();
-    const auto& numericalSolution = m_series;
+    return m_initialConditions.size();
+}
 
-    if (exactSolution.empty() || numericalSolution.empty())
-        return {};
+double StiffOdeModel::getExactEndTime()
+{
+    return m_endExactTime;
+}
 
-    size_t numSteps = numericalSolution[0]->count();
-    size_t numComponents = numericalSolution.size();
+void StiffOdeModel::cancel()
+{
+    m_cancelRequested = true;
+}
 
-    std::vector<std::vector<QPointF>> globalErrors(numComponents);
-    const double stopThreshold = 1e-09;
+bool StiffOdeModel::isCancelled() const
+{
+    return m_cancelRequested;
+}
 
-    for (size_t i = 0; i < numSteps; ++i) {
-        double t = numericalSolution[0]->at(i).x();
+void StiffOdeModel::setOutputFile(const QString& path, bool keepInMemory)
+{
+    m_outputPath = path;
+    m_keepInMemory = keepInMemory;
+}
 
-        for (size_t j = 0; j < numComponents; ++j) {
-            double numericalValue = numericalSolution[j]->at(i).y();
-            double exactValue = exactSolution[i * numComponents + j].y();
+TrajectoryFileHeader StiffOdeModel::fileHeader() const
+{
+    const SolverOptions& options = m_solver.options();
+
+    TrajectoryFileHeader header;
+    header.numComponents = static_cast<uint32_t>(m_initialConditions.size());
+    header.method = options.method;
+    header.startTime = m_startTime;
+    header.stepSize = m_stepSize;
+    header.relTolerance = options.relTolerance;
+    header.absTolerance = options.absTolerance;
+    return header;
+}
 
-            if (std::abs(numericalValue) <= stopThreshold || std::abs(exactValue) <= stopThreshold) {
-                qDebug() << "Stopped due to value exceeding threshold at t =" << t;
-                return globalErrors;
+void StiffOdeModel::solve()
+{
+    // Продолжение прошлого решения или счёт из загруженной контрольной точки
+    if (m_continuation) {
+        m_continuation = false;
+        SolverOptions options = m_solver.options();
+        options.stepSize = m_stepSize;
+        options.storeTrajectory = true;
+        options.maxSteps = SolverOptions().maxSteps;
+        m_solver.setOptions(options);
+
+        const double from = m_resumeCheckpoint.t;
+        m_fixedSizeCheckpoint.reset();
+        runSolver(from, [this](const ProgressCallback&)
+        {
+            return m_solver.resume(m_resumeCheckpoint, m_endTime, m_trajectory);
+        });
+        m_resumeCheckpoint = SolverCheckpoint();
+
+        // Продолжение дописывается к чувствительностям прошлого счёта, если они шли по тем же узлам
+        const Trajectory& sensitivities = m_solver.sensitivityTrajectory();
+        if (m_sensitivities.numComponents() == sensitivities.numComponents()
+            && m_sensitivities.size() + sensitivities.size() == m_trajectory.size()) {
+            std::vector<double> values(sensitivities.numComponents());
+            for (size_t i = 0; i < sensitivities.size(); ++i) {
+                for (size_t j = 0; j < values.size(); ++j)
+                    values[j] = sensitivities.value(j, i);
+                m_sensitivities.append(sensitivities.time(i), values);
             }
+        }
+        else
+            m_sensitivities = sensitivities.size() == m_trajectory.size() ? sensitivities : Trajectory();
+        return;
+    }
+
+    // Отображение прошлого файла закрывается до того, как он может быть перезаписан
+    m_trajectoryFile.reset();
 
-            double error = numericalValue - exactValue;
-            globalErrors[j].emplace_back(t, error);
+    TrajectoryWriter writer;
+    if (!m_outputPath.isEmpty()) {
+        if (writer.open(filePath(m_outputPath), fileHeader()))
+            m_solver.setOutputCallback([&writer](double t, const double* y) { writer.append(t, y); });
+        else
+            qDebug() << "Cannot open output file" << m_outputPath;
+    }
+
+    SolverOptions options = m_solver.options();
+    options.stepSize = m_stepSize;
+    options.storeTrajectory = !writer.isOpen() || m_keepInMemory;
+    options.maxSteps = options.storeTrajectory ? SolverOptions().maxSteps : std::numeric_limits<size_t>::max();
+    m_solver.setOptions(options);
+
+    m_eventOccurrences.clear();
+    m_fixedSizeCheckpoint.reset();
+    if (!writer.isOpen() && fixedSizeApplicable())
+        runSolver(m_startTime, [this](const ProgressCallback& progress) { return solveFixedSize(progress); });
+    else {
+        runSolver(m_startTime, [this](const ProgressCallback&)
+        {
+            return m_solver.solve(m_initialConditions, m_startTime, m_endTime, m_trajectory);
+        });
+    }
+    m_solver.setOutputCallback({});
+    m_sensitivities = m_fixedSizeCheckpoint ? Trajectory() : m_solver.sensitivityTrajectory();
+
+    if (writer.isOpen()) {
+        if (!writer.close())
+            qDebug() << "Failed to write output file" << m_outputPath;
+        else if (!m_keepInMemory) {
+            m_trajectoryFile = std::make_unique<TrajectoryReader>();
+            if (!m_trajectoryFile->open(filePath(m_outputPath)))
+                m_trajectoryFile.reset();
         }
     }
+}
 
-    return globalErrors;
+void StiffOdeModel::runSolver(double from, const std::function<SolveResult(const ProgressCallback& progress)>& run)
+{
+    const double duration = m_endTime - from;
+    int lastPercent = -1;
+    const ProgressCallback progress = [this, from, duration, &lastPercent](double t)
+    {
+        const int percent = duration > 0.0 ? static_cast<int>(100.0 * (t - from) / duration) : 100;
+        if (percent != lastPercent) {
+            lastPercent = percent;
+            emit progressChanged(percent);
+        }
+        return !m_cancelRequested.load(std::memory_order_relaxed);
+    };
+    m_solver.setProgressCallback(progress);
+    m_solver.setMethodSwitchCallback([](double t, bool stiff)
+    {
+        qDebug() << "Switched to" << (stiff ? "BDF" : "Dormand-Prince") << "at t =" << t;
+    });
+    if (!m_checkpointPath.isEmpty()) {
+        SolverOptions options = m_solver.options();
+        options.checkpointInterval = m_checkpointInterval;
+        m_solver.setOptions(options);
+        m_solver.setCheckpointCallback([path = filePath(m_checkpointPath)](const SolverCheckpoint& checkpoint)
+        {
+            if (!StiffOde::saveCheckpoint(checkpoint, path))
+                qDebug() << "Failed to write checkpoint" << QString::fromStdString(path);
+        });
+    }
+
+    // Погрешность зависит от численного решения, точное решение - нет
+    m_globalErrorValid = false;
+    m_globalError = GlobalError();
+
+    m_statistics = RunStatistics();
+    {
+        ScopedTimer timer(m_statistics.phases.solveSeconds);
+        m_solveResult = run(progress);
+    }
+    // Счётчики FixedSizeSolver записывает solveFixedSize(), событий у него нет
+    std::vector<EventOccurrence> occurrences;
+    if (!m_fixedSizeCheckpoint) {
+        m_statistics.solver = m_solver.statistics();
+        occurrences = m_solver.eventOccurrences();
+        m_eventOccurrences.insert(m_eventOccurrences.end(), occurrences.begin(), occurrences.end());
+    }
+    m_solver.setProgressCallback({});
+    m_solver.setMethodSwitchCallback({});
+    m_solver.setCheckpointCallback({});
+
+    // Конечное состояние сохраняется и при прерванном счёте, чтобы его можно было продолжить
+    if (!m_checkpointPath.isEmpty() && !saveCheckpoint(m_checkpointPath))
+        qDebug() << "Failed to write checkpoint" << m_checkpointPath;
+
+    switch (m_solveResult.status) {
+    case SolveStatus::BelowThreshold:
+        qDebug() << "Stopped due to value exceeding threshold at t =" << m_solveResult.stopTime;
+        break;
+    case SolveStatus::MaxStepsExceeded:
+        qDebug() << "Stopped due to exceeding maximum number of steps.";
+        break;
+    case SolveStatus::StepSizeTooSmall:
+        qDebug() << "Stopped due to step size becoming too small at t =" << m_solveResult.stopTime;
+        break;
+    case SolveStatus::NewtonFailure:
+        qDebug() << "Stopped due to Newton iteration failure at t =" << m_solveResult.stopTime;
+        break;
+    case SolveStatus::Cancelled:
+        qDebug() << "Cancelled at t =" << m_solveResult.stopTime;
+        break;
+    case SolveStatus::TerminalEvent:
+        qDebug() << "Stopped by terminal event at t =" << m_solveResult.stopTime;
+        break;
+    case SolveStatus::InvalidOptions:
+        qDebug() << "Solver options are not supported by the selected method.";
+        break;
+    case SolveStatus::Finished:
+        break;
+    }
+
+    for (const EventOccurrence& occurrence : occurrences)
+        qDebug() << "Event" << occurrence.event << (occurrence.rising ? "(rising)" : "(falling)")
+                 << "at t =" << occurrence.t;
 }
 
-double StiffOdeModel::getExactEndTime()
+bool StiffOdeModel::fixedSizeApplicable() const
 {
-    return m_endExactTime;
+    const Method method = m_solver.options().method;
+    const Eigen::Index n = m_linearMatrix.rows();
+    return n >= 2 && n <= maxFixedSize && static_cast<size_t>(n) == m_initialConditions.size()
+           && (method == Method::BackwardEuler || method == Method::TrBdf2) && m_solver.events().empty()
+           && m_sensitivityEntries.empty() && m_checkpointPath.isEmpty();
 }
 
-void StiffOdeModel::solve()
+SolveResult StiffOdeModel::solveFixedSize(const ProgressCallback& progress)
 {
-    if (!m_system || m_initialConditions.empty())
-        return;
+    const SolverOptions& options = m_solver.options();
+    SolverCheckpoint& checkpoint = m_fixedSizeCheckpoint.emplace();
+    SolverStatistics& statistics = m_statistics.solver;
+
+    switch (m_linearMatrix.rows()) {
+    case 2:
+        return solveLinearFixedSize<2>(m_linearMatrix, options, progress, m_initialConditions, m_startTime, m_endTime,
+                                       m_trajectory, checkpoint, statistics);
+    case 3:
+        return solveLinearFixedSize<3>(m_linearMatrix, options, progress, m_initialConditions, m_startTime, m_endTime,
+                                       m_trajectory, checkpoint, statistics);
+    case 4:
+        return solveLinearFixedSize<4>(m_linearMatrix, options, progress, m_initialConditions, m_startTime, m_endTime,
+                                       m_trajectory, checkpoint, statistics);
+    case 5:
+        return solveLinearFixedSize<5>(m_linearMatrix, options, progress, m_initialConditions, m_startTime, m_endTime,
+                                       m_trajectory, checkpoint, statistics);
+    case 6:
+        return solveLinearFixedSize<6>(m_linearMatrix, options, progress, m_initialConditions, m_startTime, m_endTime,
+                                       m_trajectory, checkpoint, statistics);
+    case 7:
+        return solveLinearFixedSize<7>(m_linearMatrix, options, progress, m_initialConditions, m_startTime, m_endTime,
+                                       m_trajectory, checkpoint, statistics);
+    default:
+        static_assert(maxFixedSize == 8, "solveFixedSize() covers sizes 2..maxFixedSize");
+        return solveLinearFixedSize<8>(m_linearMatrix, options, progress, m_initialConditions, m_startTime, m_endTime,
+                                       m_trajectory, checkpoint, statistics);
+    }
+}
 
-    size_t numEquations = m_initialConditions.size();
-    const size_t maxSteps = 1e6;
-    size_t currentStep = 0;
+const SolverCheckpoint& StiffOdeModel::finalState() const
+{
+    return m_fixedSizeCheckpoint ? *m_fixedSizeCheckpoint : m_solver.checkpoint();
+}
 
-    for (auto* series : m_series) {
-        delete series;
-    }
-    m_series.clear();
+bool StiffOdeModel::continueFrom(const StiffOdeModel& previous)
+{
+    const SolverCheckpoint& checkpoint = previous.finalState();
+    const SolverOptions& options = m_solver.options();
+    const SolverOptions& previousOptions = previous.m_solver.options();
+
+    // Продолжать можно только то же решение: та же задача, метод и допуски, траектория в памяти
+    // и счёт, дошедший до своего конца
+    const bool sameProblem = m_initialConditions == previous.m_initialConditions
+                             && m_startTime == previous.m_startTime && m_stepSize == previous.m_stepSize
+                             && m_linearMatrix.rows() == previous.m_linearMatrix.rows()
+                             && m_linearMatrix.cols() == previous.m_linearMatrix.cols()
+                             && m_linearMatrix == previous.m_linearMatrix
+                             && m_sensitivityEntries == previous.m_sensitivityEntries
+                             && options.method == previousOptions.method
+                             && options.relTolerance == previousOptions.relTolerance
+                             && options.absTolerance == previousOptions.absTolerance;
+    const bool resumable = previous.m_solveResult.status == SolveStatus::Finished && !previous.m_trajectoryFile
+                           && previous.m_outputPath.isEmpty() && m_outputPath.isEmpty()
+                           && !previous.m_trajectory.empty()
+                           && static_cast<size_t>(checkpoint.y.size()) == m_initialConditions.size()
+                           && checkpoint.t < m_endTime;
+    if (!sameProblem || !resumable)
+        return false;
+
+    m_trajectory = previous.m_trajectory;
+    m_sensitivities = previous.m_sensitivities;
+    m_eventOccurrences = previous.m_eventOccurrences;
+    m_resumeCheckpoint = checkpoint;
+    m_continuation = true;
+    return true;
+}
 
-    for (size_t i = 0; i < numEquations; ++i) {
-        m_series.push_back(new QLineSeries(this));
-    }
+void StiffOdeModel::setCheckpointFile(const QString& path, size_t interval)
+{
+    m_checkpointPath = path;
+    m_checkpointInterval = interval;
+}
 
-    std::vector<double> y = m_initialConditions;
-    double t = m_startTime;
-    const double stopThreshold = 1e-09;
-    bool stopFlag = false; // Флаг остановки
+bool StiffOdeModel::saveCheckpoint(const QString& path) const
+{
+    const SolverCheckpoint& checkpoint = finalState();
+    return checkpoint.y.size() > 0 && StiffOde::saveCheckpoint(checkpoint, filePath(path));
+}
 
-    // Матрица Якобиана (для вашей системы она постоянна)
-    Eigen::Matrix2d A;
-    A << -500.005, 499.995,
-        499.995, -500.005;
+bool StiffOdeModel::loadCheckpoint(const QString& path)
+{
+    SolverCheckpoint checkpoint;
+    if (!StiffOde::loadCheckpoint(filePath(path), checkpoint)
+        || static_cast<size_t>(checkpoint.y.size()) != m_initialConditions.size())
+        return false;
+
+    // Траектория начинается с контрольной точки; точное решение от этого не меняется
+    m_trajectoryFile.reset();
+    m_trajectory.reset(0);
+    m_sensitivities.reset(0);
+    m_eventOccurrences.clear();
+    m_resumeCheckpoint = std::move(checkpoint);
+    m_continuation = true;
+    return true;
+}
 
-    // Матрица (I - hA)
-    Eigen::Matrix2d I = Eigen::Matrix2d::Identity();
-    Eigen::Matrix2d M = I - m_stepSize * A;
+EnsembleResult StiffOdeModel::solveEnsemble(const Matrix& initialConditions) const
+{
+    const size_t n = static_cast<size_t>(initialConditions.rows());
 
-    // Предварительно инвертируем матрицу, так как система линейная
-    Eigen::Matrix2d M_inv = M.inverse();
+    EnsembleSolver ensemble;
+    if (m_linearMatrix.rows() == initialConditions.rows()) {
+        ensemble.setSystem(linearEnsembleSystem(m_linearMatrix), n);
+        ensemble.setJacobian(linearEnsembleJacobian(m_linearMatrix));
+    }
+    else if (m_solver.inPlaceSystem())
+        ensemble.setSystem(ensembleSystem(m_solver.inPlaceSystem(), n), n);
+    else if (m_solver.system())
+        ensemble.setSystem(ensembleSystem(inPlaceSystem(m_solver.system(), n), n), n);
+
+    SolverOptions options = m_solver.options();
+    options.stepSize = 0.0;
+    ensemble.setOptions(options);
+    ensemble.setCancelFlag(&m_cancelRequested);
+
+    const EnsembleResult result = ensemble.solve(initialConditions, Matrix(), m_startTime, m_endTime);
+    qDebug() << "Ensemble of" << initialConditions.cols() << "members solved in" << result.elapsedSeconds << "s,"
+             << result.trajectoriesPerSecond << "trajectories/s";
+    return result;
+}
 
-    while (t <= m_endTime && !stopFlag) {
-        // Проверка порогового значения
-        bool belowThreshold = std::all_of(y.begin(), y.end(),
-                                          [stopThreshold](double val) { return std::abs(val) <= stopThreshold; });
+ConvergenceStudyResult StiffOdeModel::runConvergenceStudy(StudyParameter parameter, double first, double ratio,
+                                                          size_t count)
+{
+    if (m_initialConditions.empty() || m_linearMatrix.rows() != static_cast<Eigen::Index>(m_initialConditions.size()))
+        return {};
 
-        if (belowThreshold) {
-            qDebug() << "Stopped due to value exceeding threshold at t =" << t;
-            break;
-        }
+    ConvergenceStudy study(m_solver, [this](double t, double* y) { exactSolutionAt(t, y); });
+    study.setParameter(parameter, first, ratio, count);
+    study.setCancelFlag(&m_cancelRequested);
+    study.setProgressCallback([this](double fraction)
+    {
+        emit progressChanged(static_cast<int>(100.0 * fraction));
+        return true;
+    });
+
+    const ConvergenceStudyResult result = study.run(m_initialConditions, m_startTime, m_endTime);
+    qDebug() << "Convergence study of" << count << "runs finished in" << result.elapsedSeconds << "s, order"
+             << result.maxErrorOrder;
+    return result;
+}
 
-        if (currentStep++ > maxSteps) {
-            qDebug() << "Stopped due to exceeding maximum number of steps.";
-            break;
-        }
+const Trajectory& StiffOdeModel::getTrajectory() const
+{
+    return m_trajectory;
+}
 
-        // Записываем текущие значения в график
-        for (size_t i = 0; i < numEquations; ++i) {
-            m_series[i]->append(t, y[i]);
-        }
+const Trajectory& StiffOdeModel::getSensitivities() const
+{
+    return m_sensitivities;
+}
 
-        // Вычисляем следующее значение
-        double tNext = t + m_stepSize;
+const TrajectoryData& StiffOdeModel::getTrajectoryData() const
+{
+    if (m_trajectoryFile)
+        return *m_trajectoryFile;
+    return m_trajectory;
+}
 
-        // Решаем линейную систему (I - hA)y_{n+1} = y_n
-        Eigen::Vector2d yVec(y[0], y[1]);
-        Eigen::Vector2d yNextVec = M_inv * yVec;
+bool StiffOdeModel::loadTrajectory(const QString& path)
+{
+    auto file = std::make_unique<TrajectoryReader>();
+    if (!file->open(filePath(path)))
+        return false;
+
+    const TrajectoryFileHeader& header = file->header();
+    SolverOptions options = m_solver.options();
+    options.method = header.method;
+    options.relTolerance = header.relTolerance;
+    options.absTolerance = header.absTolerance;
+    m_solver.setOptions(options);
+
+    m_startTime = header.startTime;
+    m_stepSize = header.stepSize;
+    m_initialConditions.assign(header.numComponents, 0.0);
+    m_endTime = m_startTime;
+    if (!file->empty()) {
+        for (size_t j = 0; j < m_initialConditions.size(); ++j)
+            m_initialConditions[j] = file->value(j, 0);
+        m_endTime = file->time(file->size() - 1);
+    }
 
-        y = { yNextVec[0], yNextVec[1] };
-        t = tNext;
+    m_trajectory.reset(header.numComponents);
+    m_sensitivities.reset(0);
+    m_solveResult = { SolveStatus::Finished, m_endTime, file->empty() ? 0 : file->size() - 1 };
+    m_statistics = RunStatistics();
+    m_eventOccurrences.clear();
+    m_trajectoryFile = std::move(file);
+    updateLinearSolution();
+    invalidateCache();
+    return true;
+}
+
+bool StiffOdeModel::saveTrajectory(const QString& path) const
+{
+    return StiffOde::saveTrajectory(getTrajectoryData(), filePath(path), fileHeader());
+}
+
+bool StiffOdeModel::exportCsv(const QString& path, double sampleStep) const
+{
+    const TrajectoryData& trajectory = getTrajectoryData();
+    if (sampleStep <= 0.0 || trajectory.empty()) {
+        if (!m_sensitivities.empty() && m_sensitivities.size() == trajectory.size())
+            return StiffOde::exportCsv(trajectory, m_sensitivities, filePath(path));
+        return StiffOde::exportCsv(trajectory, filePath(path));
     }
+
+    DenseOutput solution = m_solver.denseOutput(trajectory);
+    return StiffOde::exportCsv(solution, trajectory.numComponents(), sampleStep, filePath(path));
+}
+
+const SolveResult& StiffOdeModel::getSolveResult() const
+{
+    return m_solveResult;
+}
+
+const std::vector<EventOccurrence>& StiffOdeModel::getEventOccurrences() const
+{
+    return m_eventOccurrences;
+}
+
+const RunStatistics& StiffOdeModel::getStatistics() const
+{
+    return m_statistics;
+}
+
+void StiffOdeModel::setUiTime(double seconds)
+{
+    m_statistics.phases.uiSeconds = seconds;
 }
 
-const std::vector<QLineSeries*>& StiffOdeModel::getSeries() const
+void StiffOdeModel::setChartDataTime(double seconds)
 {
-    return m_series;
+    m_statistics.phases.chartDataSeconds = seconds;
 }
 }
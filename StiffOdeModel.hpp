@@ -1,9 +1,22 @@
 #pragma once
 
-#include <QObject>
-#include <QtCharts/QLineSeries>
+#include "StiffOdeConvergence.hpp"
+#include "StiffOdeEnsemble.hpp"
+#include "StiffOdeGlobalError.hpp"
+#include "StiffOdePropagator.hpp"
+#include "StiffOdeSolver.hpp"
+#include "StiffOdeStatistics.hpp"
+#include "StiffOdeTrajectory.hpp"
+#include "StiffOdeTrajectoryFile.hpp"
 
-using namespace QtCharts;
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
 
 namespace StiffOde
 {
@@ -13,23 +26,126 @@ class StiffOdeModel : public QObject
 
 public:
     explicit StiffOdeModel(QObject* parent = nullptr);
-    void setSystem(const std::function<std::vector<double>(const std::vector<double>&, double)>& system);
+    // Без Якобиана он вычисляется конечными разностями
+    void setSystem(const System& system, const JacobianFunction& jacobian = {});
+    void setInPlaceSystem(const InPlaceSystem& system, const JacobianFunction& jacobian = {});
+    // Линейная система y' = A y; только для неё доступно точное решение
+    void setLinearSystem(const Matrix& matrix);
     void setInitialConditions(const std::vector<double>& initialConditions, double startTime);
     void setParameters(double stepSize, double endTime, double endExactTime, double startExactTime);
+    void setMethod(Method method, double relTolerance, double absTolerance);
+    // Функции событий g(t, y); терминальные события заканчивают solve() в точке, где g меняет знак
+    void setEvents(const std::vector<Event>& events);
+    // Прямые чувствительности dy/dp к элементам A линейной системы (пары строка-столбец), нулевые
+    // в начальный момент; считаются методами BackwardEuler и Bdf вместе с решением. Пустой список отключает
+    bool setLinearSensitivities(const std::vector<std::pair<Eigen::Index, Eigen::Index>>& entries);
+    // Запись решения в двоичный файл по мере счёта; без копии в памяти число шагов не ограничивается,
+    // а траектория после решения читается из файла. Пустой путь отключает запись.
+    void setOutputFile(const QString& path, bool keepInMemory = false);
+    // Решение на [startTime, endTime]; после continueFrom() или loadCheckpoint() - продолжение
+    // из контрольной точки с дописыванием к имеющейся траектории
     void solve();
-    const std::vector<QLineSeries*>& getSeries() const;
-    std::vector<QPointF> computeExactSolution() const;
-    std::vector<std::vector<QPointF>>computeGlobalError() const;
+    // Подготовка к продолжению решения previous до нового конечного момента вместо счёта с начала.
+    // Вызывается после задания параметров; false, если задача, метод или допуски отличаются,
+    // прошлый счёт не завершён или конец отрезка не увеличился
+    bool continueFrom(const StiffOdeModel& previous);
+    // Состояние решателя в конце последнего solve(): запись и продолжение с него следующим solve()
+    bool saveCheckpoint(const QString& path) const;
+    bool loadCheckpoint(const QString& path);
+    // Автосохранение состояния каждые interval принятых шагов и в конце счёта; пустой путь отключает
+    void setCheckpointFile(const QString& path, size_t interval = 1000);
+    // Решение той же системы на [startTime, endTime] для множества начальных условий (по столбцу на член);
+    // после cancel() оставшиеся блоки ансамбля не решаются
+    EnsembleResult solveEnsemble(const Matrix& initialConditions) const;
+    // Исследование сходимости текущим методом на [startTime, endTime] для параметров first * ratio^i, i < count;
+    // прогоны идут параллельно и сравниваются с точным решением. Пустой результат, если его нет;
+    // cancel() прерывает и уже начатые прогоны
+    ConvergenceStudyResult runConvergenceStudy(StudyParameter parameter, double first, double ratio, size_t count);
+    const Trajectory& getTrajectory() const;
+    // Численное решение из памяти или из файла, если оно записывалось в файл или было загружено
+    const TrajectoryData& getTrajectoryData() const;
+    // Чувствительности последнего решения в узлах траектории: компонента i * n + j - dy_j/dp_i
+    const Trajectory& getSensitivities() const;
+    bool loadTrajectory(const QString& path);
+    bool saveTrajectory(const QString& path) const;
+    // Шаг sampleStep > 0 - экспорт на равномерной сетке по непрерывному продолжению решения;
+    // в узлах решения вместе с ним экспортируются и чувствительности
+    bool exportCsv(const QString& path, double sampleStep = 0.0) const;
+    const SolveResult& getSolveResult() const;
+    // События последнего решения в порядке времени
+    const std::vector<EventOccurrence>& getEventOccurrences() const;
+    // Счётчики последнего решения и длительность этапов расчёта
+    const RunStatistics& getStatistics() const;
+    // Время подготовки данных графиков в рабочем потоке и построения графиков и таблиц измеряется виджетом
+    void setUiTime(double seconds);
+    void setChartDataTime(double seconds);
+    // Погрешность и её статистика в узлах сетки точного решения, попадающих на отрезок численного решения;
+    // кэшируется до изменения системы, начальных условий или параметров
+    const GlobalError& computeGlobalError() const;
+    // Точное решение в произвольной точке; false, если оно недоступно
+    bool exactSolutionAt(double t, double* y) const;
+    // Одна компонента точного решения; 0, если оно недоступно. Графики точного решения строятся по ней
+    // при прореживании, без хранения решения на всей сетке
+    double exactComponentAt(double t, size_t component) const;
+    // Сетка точного решения без его вычисления: узлы fixedStepTime(startExactTime, endExactTime, h, i),
+    // i < exactGridSize(), как у решателя с постоянным шагом; 0, если точное решение недоступно
+    size_t exactGridSize() const;
+    double exactGridTime(size_t i) const;
+    size_t numComponents() const;
     double getExactEndTime();
 
+    // Может вызываться из любого потока; solve() и расчёт погрешности завершаются досрочно
+    void cancel();
+    bool isCancelled() const;
+
+signals:
+    // Выполнение solve() в процентах; испускается из потока, в котором идёт решение
+    void progressChanged(int percent);
+
 private:
-    std::function<std::vector<double>(const std::vector<double>&, double)> m_system;
+    // Счёт run() с отчётом о прогрессе от момента from, контрольными точками, статистикой и журналом;
+    // run() получает обратный вызов прогресса, уже заданный m_solver
+    void runSolver(double from, const std::function<SolveResult(const ProgressCallback& progress)>& run);
+    // Линейная система размерности до maxFixedSize без событий, чувствительностей и автосохранения
+    // решается FixedSizeSolver<N> неявным методом Эйлера или TR-BDF2
+    bool fixedSizeApplicable() const;
+    SolveResult solveFixedSize(const ProgressCallback& progress);
+    // Конечное состояние последнего счёта: FixedSizeSolver или m_solver
+    const SolverCheckpoint& finalState() const;
+    void clearSensitivities();
+    GlobalError evaluateGlobalError() const;
+    void invalidateCache();
+    // Пересоздаёт m_linearSolution после смены матрицы, начальных условий или начального момента
+    void updateLinearSolution();
+    TrajectoryFileHeader fileHeader() const;
+
     std::vector<double> m_initialConditions;
     double m_startTime;
     double m_endTime;
     double m_endExactTime;
     double m_startExactTime;
     double m_stepSize;
-    std::vector<QLineSeries*> m_series;
+    StiffOdeSolver m_solver;
+    Matrix m_linearMatrix;
+    // Точное решение линейной системы в произвольный момент; пусто, если система не линейная
+    std::optional<LinearSolution> m_linearSolution;
+    Trajectory m_trajectory;
+    std::vector<std::pair<Eigen::Index, Eigen::Index>> m_sensitivityEntries;
+    Trajectory m_sensitivities;
+    SolveResult m_solveResult;
+    std::vector<EventOccurrence> m_eventOccurrences;
+    QString m_outputPath;
+    bool m_keepInMemory {false};
+    std::unique_ptr<TrajectoryReader> m_trajectoryFile;
+    QString m_checkpointPath;
+    size_t m_checkpointInterval {1000};
+    SolverCheckpoint m_resumeCheckpoint;
+    std::optional<SolverCheckpoint> m_fixedSizeCheckpoint;
+    bool m_continuation {false};
+
+    mutable GlobalError m_globalError;
+    mutable bool m_globalErrorValid {false};
+    mutable RunStatistics m_statistics;
+    std::atomic<bool> m_cancelRequested {false};
 };
 }
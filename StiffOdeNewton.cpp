@@ -0,0 +1,129 @@
+#include "StiffOdeNewton.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace StiffOde
+{
+namespace
+{
+// Скорость сходимости, начиная с которой Якобиан считается устаревшим
+const double slowConvergenceRate = 0.3;
+// Требуемая точность итераций во взвешенной норме по умолчанию (погрешность шага допускается до 1)
+const double defaultTolerance = 0.03;
+
+double weightedNorm(const Vector& v, const Vector& scale)
+{
+    return std::sqrt((v.array() / scale.array()).square().sum() / static_cast<double>(v.size()));
+}
+}
+
+NewtonSolver::NewtonSolver(const InPlaceSystem& system, std::unique_ptr<LinearSolver> linearSolver, Eigen::Index size,
+                           size_t maxIterations)
+    : m_system(system), m_linearSolver(std::move(linearSolver)), m_maxIterations(maxIterations),
+    m_tolerance(defaultTolerance), m_f(size), m_residual(size), m_delta(size)
+{
+}
+
+void NewtonSolver::prepare(double t, const Vector& y, double hGamma)
+{
+    m_hGamma = hGamma;
+    m_jacobianCurrent = false;
+
+    if (m_jacobianStale)
+        updateJacobian(t, y);
+
+    if (m_factorizationStale || m_hGamma != m_factorizedHGamma)
+        factorize();
+}
+
+bool NewtonSolver::solve(double t, const Vector& rhs, const Vector& scale, Vector& z)
+{
+    // Оценка скорости сходимости переносится с прошлых стадий, чтобы принимать решение уже после первой итерации
+    double eta = std::pow(std::max(m_convergenceFactor, std::numeric_limits<double>::epsilon()), 0.8);
+    double previousNorm = 0.0;
+
+    for (size_t k = 0; k < m_maxIterations; ++k) {
+        m_iterations = k + 1;
+        if (m_statistics != nullptr)
+            count(m_statistics->newtonIterations);
+        evaluate(m_system, t, z, m_f);
+        m_residual.noalias() = z - m_hGamma * m_f - rhs;
+        m_linearSolver->solve(m_residual, m_delta);
+        z -= m_delta;
+
+        const double norm = weightedNorm(m_delta, scale);
+        if (!std::isfinite(norm))
+            break;
+
+        double rate = 0.0;
+        if (k > 0) {
+            rate = norm / previousNorm;
+            if (rate >= 0.9)
+                break;
+            eta = rate / (1.0 - rate);
+        }
+
+        if (norm == 0.0 || eta * norm <= m_tolerance) {
+            m_convergenceFactor = eta;
+            if (rate > slowConvergenceRate)
+                m_jacobianStale = true;
+            return true;
+        }
+
+        previousNorm = norm;
+    }
+
+    m_convergenceFactor = 1.0;
+    m_jacobianStale = true;
+    return false;
+}
+
+void NewtonSolver::solveLinear(const Vector& b, Vector& x) const
+{
+    m_linearSolver->solve(b, x);
+}
+
+void NewtonSolver::setStatistics(SolverStatistics* statistics)
+{
+    m_statistics = statistics;
+}
+
+void NewtonSolver::setTolerance(double tolerance)
+{
+    m_tolerance = tolerance;
+}
+
+size_t NewtonSolver::iterations() const
+{
+    return m_iterations;
+}
+
+bool NewtonSolver::jacobianCurrent() const
+{
+    return m_jacobianCurrent;
+}
+
+void NewtonSolver::invalidateJacobian()
+{
+    m_jacobianStale = true;
+}
+
+void NewtonSolver::updateJacobian(double t, const Vector& y)
+{
+    m_linearSolver->evaluateJacobian(t, y);
+
+    m_jacobianStale = false;
+    m_jacobianCurrent = true;
+    m_factorizationStale = true;
+}
+
+void NewtonSolver::factorize()
+{
+    m_linearSolver->factorize(m_hGamma);
+    m_factorizedHGamma = m_hGamma;
+    m_factorizationStale = false;
+}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "StiffOdeLinearSolver.hpp"
+#include "StiffOdeStatistics.hpp"
+#include "StiffOdeTypes.hpp"
+
+#include <cstddef>
+#include <memory>
+
+namespace StiffOde
+{
+// Упрощённый метод Ньютона для неявных стадий вида z - hGamma * f(t, z) = rhs.
+// Якобиан и LU-разложение (I - hGamma * J) переиспользуются между итерациями и шагами:
+// Якобиан пересчитывается только после медленной сходимости или отказа,
+// разложение - при новом Якобиане или изменении hGamma. Поэтому вызывающий код не меняет шаг
+// ради небольшого увеличения. Рабочие векторы выделяются один раз в конструкторе.
+class NewtonSolver
+{
+public:
+    NewtonSolver(const InPlaceSystem& system, std::unique_ptr<LinearSolver> linearSolver, Eigen::Index size,
+                 size_t maxIterations);
+
+    void prepare(double t, const Vector& y, double hGamma);
+    bool solve(double t, const Vector& rhs, const Vector& scale, Vector& z);
+    void solveLinear(const Vector& b, Vector& x) const;
+    // Итерации добавляются к statistics->newtonIterations
+    void setStatistics(SolverStatistics* statistics);
+    // Точность итераций во взвешенной норме scale; по умолчанию 0.03 от допустимой погрешности шага
+    void setTolerance(double tolerance);
+
+    // Число итераций последнего вызова solve()
+    size_t iterations() const;
+    bool jacobianCurrent() const;
+    void invalidateJacobian();
+
+private:
+    void updateJacobian(double t, const Vector& y);
+    void factorize();
+
+    const InPlaceSystem& m_system;
+    std::unique_ptr<LinearSolver> m_linearSolver;
+    size_t m_maxIterations;
+    SolverStatistics* m_statistics {nullptr};
+    double m_tolerance;
+    Vector m_f;
+    Vector m_residual;
+    Vector m_delta;
+    size_t m_iterations = 0;
+    double m_hGamma = 0.0;
+    double m_factorizedHGamma = 0.0;
+    double m_convergenceFactor = 1.0;
+    bool m_jacobianStale = true;
+    bool m_jacobianCurrent = false;
+    bool m_factorizationStale = true;
+};
+}
@@ -0,0 +1,148 @@
+#include "StiffOdePropagator.hpp"
+
+#include <Eigen/Eigenvalues>
+#include <cmath>
+#include <complex>
+#include <unsupported/Eigen/MatrixFunctions>
+
+namespace StiffOde
+{
+namespace
+{
+// Предел числа обусловленности базиса собственных векторов, как в GlobalErrorKernel
+const double maxEigenvectorCondition = 1e8;
+}
+
+Matrix matrixExponential(const Matrix& a)
+{
+    return a.exp();
+}
+
+LinearPropagator::LinearPropagator(const Matrix& a, double stepSize)
+    : m_matrix(a), m_stepSize(stepSize), m_stepMatrix(matrixExponential(stepSize * a))
+{
+}
+
+double LinearPropagator::stepSize() const
+{
+    return m_stepSize;
+}
+
+const Matrix& LinearPropagator::stepMatrix() const
+{
+    return m_stepMatrix;
+}
+
+Matrix LinearPropagator::power(size_t k) const
+{
+    Matrix result = Matrix::Identity(m_stepMatrix.rows(), m_stepMatrix.cols());
+    Matrix square = m_stepMatrix;
+
+    while (k > 0) {
+        if (k & 1u)
+            result = result * square;
+        k >>= 1u;
+        if (k > 0)
+            square = square * square;
+    }
+    return result;
+}
+
+void LinearPropagator::advance(const Vector& y, Vector& yNext) const
+{
+    yNext.noalias() = m_stepMatrix * y;
+}
+
+void LinearPropagator::jump(size_t k, const Vector& y, Vector& yNext) const
+{
+    yNext.noalias() = power(k) * y;
+}
+
+void LinearPropagator::sample(const Vector& initialConditions, double startTime, double gridStart, size_t count,
+                              Trajectory& trajectory, size_t anchorInterval) const
+{
+    trajectory.reset(static_cast<size_t>(initialConditions.size()));
+    if (count == 0)
+        return;
+
+    trajectory.reserve(count);
+
+    // Состояние в первом узле сетки: сдвиг на произвольное (не кратное h) время
+    const Vector first = matrixExponential((gridStart - startTime) * m_matrix) * initialConditions;
+    Vector y = first;
+    Vector yNext(y.size());
+
+    for (size_t i = 0; i < count; ++i) {
+        trajectory.append(gridStart + static_cast<double>(i) * m_stepSize, y.data());
+
+        if (anchorInterval > 0 && (i + 1) % anchorInterval == 0) {
+            jump(i + 1, first, yNext);
+        }
+        else {
+            advance(y, yNext);
+        }
+        y.swap(yNext);
+    }
+}
+
+LinearSolution::LinearSolution(const Matrix& a, const Vector& initialConditions, double startTime)
+    : m_matrix(a),
+    m_initialConditions(initialConditions),
+    m_startTime(startTime)
+{
+    if (a.rows() == 0 || a.rows() != a.cols() || a.rows() != initialConditions.size())
+        return;
+
+    const Eigen::EigenSolver<Matrix> eigen(a);
+    if (eigen.info() != Eigen::Success)
+        return;
+
+    const ComplexMatrix vectors = eigen.eigenvectors();
+    const Vector singularValues = Eigen::JacobiSVD<ComplexMatrix>(vectors).singularValues();
+    const double smallest = singularValues(singularValues.size() - 1);
+    if (!(smallest > 0.0) || singularValues(0) / smallest > maxEigenvectorCondition)
+        return;
+
+    m_eigenvalues = eigen.eigenvalues();
+    m_eigenvectors = vectors;
+    m_coefficients = vectors.fullPivLu().solve(initialConditions.cast<std::complex<double>>());
+    m_modal = true;
+}
+
+bool LinearSolution::isModal() const
+{
+    return m_modal;
+}
+
+void LinearSolution::evaluate(double t, double* y) const
+{
+    const Eigen::Index n = m_initialConditions.size();
+    Eigen::Map<Vector> result(y, n);
+    if (!m_modal) {
+        result.noalias() = matrixExponential((t - m_startTime) * m_matrix) * m_initialConditions;
+        return;
+    }
+
+    // Сумма мод c_k exp(λ_k (t - t0)) v_k; мнимые части сопряжённых пар взаимно уничтожаются
+    const double tau = t - m_startTime;
+    result.setZero();
+    for (Eigen::Index k = 0; k < n; ++k) {
+        const std::complex<double> weight = m_coefficients[k] * std::exp(m_eigenvalues[k] * tau);
+        result += (m_eigenvectors.col(k) * weight).real();
+    }
+}
+
+double LinearSolution::component(double t, Eigen::Index j) const
+{
+    if (!m_modal) {
+        const Vector y = matrixExponential((t - m_startTime) * m_matrix) * m_initialConditions;
+        return y[j];
+    }
+
+    const double tau = t - m_startTime;
+    std::complex<double> sum = 0.0;
+    for (Eigen::Index k = 0; k < m_eigenvalues.size(); ++k)
+        sum += m_eigenvectors(j, k) * m_coefficients[k] * std::exp(m_eigenvalues[k] * tau);
+    return sum.real();
+}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "StiffOdeGrid.hpp"
+#include "StiffOdeTrajectory.hpp"
+#include "StiffOdeTypes.hpp"
+
+#include <cstddef>
+
+namespace StiffOde
+{
+// exp(A) масштабированием и возведением в квадрат с аппроксимацией Паде (Higham, 2005)
+Matrix matrixExponential(const Matrix& a);
+
+// Точное решение линейной системы y' = A y с постоянной матрицей на равномерной сетке с шагом h.
+// Пропагатор exp(hA) вычисляется один раз, дальше каждый узел стоит одного умножения матрицы на вектор;
+// для перехода сразу на k узлов exp(khA) получается повторным возведением пропагатора в квадрат.
+class LinearPropagator
+{
+public:
+    LinearPropagator(const Matrix& a, double stepSize);
+
+    double stepSize() const;
+    const Matrix& stepMatrix() const;
+    // exp(k h A)
+    Matrix power(size_t k) const;
+
+    void advance(const Vector& y, Vector& yNext) const;
+    void jump(size_t k, const Vector& y, Vector& yNext) const;
+
+    // Узлы gridStart + i*h, i = 0..count-1, для решения с y(startTime) = initialConditions.
+    // Каждые anchorInterval узлов состояние заново получается прыжком от начала сетки,
+    // чтобы ошибки округления не накапливались на длинных сетках.
+    void sample(const Vector& initialConditions, double startTime, double gridStart, size_t count,
+                Trajectory& trajectory, size_t anchorInterval = 4096) const;
+
+private:
+    Matrix m_matrix;
+    double m_stepSize;
+    Matrix m_stepMatrix;
+};
+
+// Точное решение y(t) = exp((t - t0) A) y0 линейной системы в произвольный момент. Если A диагонализуема
+// с хорошо обусловленным базисом собственных векторов, разложение A = V Λ V^-1 и коэффициенты c = V^-1 y0
+// считаются один раз в конструкторе, и каждый момент стоит n комплексных экспонент и O(n^2) операций
+// без выделения памяти; комплексный спектр допускается. Для дефектных и плохо обусловленных A
+// exp((t - t0) A) вычисляется для каждого момента заново. evaluate() можно вызывать из нескольких потоков
+class LinearSolution
+{
+public:
+    LinearSolution(const Matrix& a, const Vector& initialConditions, double startTime);
+
+    bool isModal() const;
+    void evaluate(double t, double* y) const;
+    // Одна компонента y_j(t): в спектральном представлении O(n) операций вместо O(n^2)
+    double component(double t, Eigen::Index j) const;
+
+private:
+    Matrix m_matrix;
+    Vector m_initialConditions;
+    double m_startTime;
+    bool m_modal {false};
+    ComplexVector m_eigenvalues;
+    ComplexMatrix m_eigenvectors;
+    ComplexVector m_coefficients;
+};
+}
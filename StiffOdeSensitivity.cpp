@@ -0,0 +1,120 @@
+#include "StiffOdeSensitivity.hpp"
+#include "StiffOdeLinearSolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace StiffOde
+{
+namespace
+{
+// Точность итераций во взвешенной норме, как у метода Ньютона основного шага
+const double sensitivityTolerance = 0.03;
+}
+
+SensitivityCorrector::SensitivityCorrector(const InPlaceSystem& system, const JacobianFunction& jacobian,
+                                           const ParameterJacobianFunction& parameterJacobian, Eigen::Index size,
+                                           Eigen::Index parameters, size_t maxIterations)
+    : m_system(system),
+    m_jacobian(jacobian),
+    m_parameterJacobian(parameterJacobian),
+    m_maxIterations(maxIterations),
+    m_product(size, parameters),
+    m_residual(size, parameters),
+    m_perturbed(size),
+    m_fForward(size),
+    m_fBackward(size),
+    m_delta(size),
+    m_column(size)
+{
+}
+
+void SensitivityCorrector::derivatives(double t, const Vector& y, const Matrix& s, Matrix& derivatives)
+{
+    load(t, y);
+    multiply(t, y, s, derivatives);
+    derivatives += m_parameterDerivatives;
+}
+
+bool SensitivityCorrector::solve(const NewtonSolver& newton, double t, const Vector& y, double c, const Matrix& rhs,
+                                 const Matrix& scale, Matrix& s)
+{
+    load(t, y);
+
+    // Как в методе Ньютона, оценка скорости сходимости переносится с прошлых шагов: для линейной по y
+    // системы с точным разложением итерация сходится за один шаг, и проверочная итерация не нужна
+    double eta = std::pow(std::max(m_convergenceFactor, std::numeric_limits<double>::epsilon()), 0.8);
+    const double count = static_cast<double>(s.size());
+    double previousNorm = 0.0;
+    for (size_t k = 0; k < m_maxIterations; ++k) {
+        multiply(t, y, s, m_product);
+        m_residual.noalias() = s - c * (m_product + m_parameterDerivatives) - rhs;
+
+        double sumSquares = 0.0;
+        for (Eigen::Index i = 0; i < s.cols(); ++i) {
+            m_column = m_residual.col(i);
+            newton.solveLinear(m_column, m_delta);
+            s.col(i) -= m_delta;
+            sumSquares += (m_delta.array() / scale.col(i).array()).square().sum();
+        }
+
+        const double norm = std::sqrt(sumSquares / count);
+        if (!std::isfinite(norm))
+            break;
+
+        if (k > 0) {
+            const double rate = norm / previousNorm;
+            if (rate >= 0.9)
+                break;
+            eta = rate / (1.0 - rate);
+        }
+
+        if (norm == 0.0 || eta * norm <= sensitivityTolerance) {
+            m_convergenceFactor = eta;
+            return true;
+        }
+        previousNorm = norm;
+    }
+
+    m_convergenceFactor = 1.0;
+    return false;
+}
+
+void SensitivityCorrector::load(double t, const Vector& y)
+{
+    if (m_jacobian) {
+        m_y.assign(y.data(), y.data() + y.size());
+        m_jacobianMatrix = m_jacobian(m_y, t);
+    }
+    m_parameterDerivatives = m_parameterJacobian(t, y.data());
+}
+
+void SensitivityCorrector::multiply(double t, const Vector& y, const Matrix& s, Matrix& product)
+{
+    if (m_jacobian) {
+        product.noalias() = m_jacobianMatrix * s;
+        return;
+    }
+
+    // Центральная разность J v ~ (f(t, y + sigma v) - f(t, y - sigma v)) / (2 sigma): у односторонней
+    // ошибка округления порядка sqrt(eps) |J| |v| на жёстких системах выше точности итераций
+    const double eps = std::cbrt(std::numeric_limits<double>::epsilon());
+    const double yNorm = y.lpNorm<Eigen::Infinity>();
+    product.resize(s.rows(), s.cols());
+    for (Eigen::Index i = 0; i < s.cols(); ++i) {
+        const double sNorm = s.col(i).lpNorm<Eigen::Infinity>();
+        if (sNorm == 0.0) {
+            product.col(i).setZero();
+            continue;
+        }
+        const double sigma = eps * (1.0 + yNorm) / sNorm;
+        m_perturbed.noalias() = y + sigma * s.col(i);
+        evaluate(m_system, t, m_perturbed, m_fForward);
+        m_perturbed.noalias() = y - sigma * s.col(i);
+        evaluate(m_system, t, m_perturbed, m_fBackward);
+        product.col(i) = (m_fForward - m_fBackward) / (2.0 * sigma);
+    }
+}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "StiffOdeNewton.hpp"
+#include "StiffOdeTypes.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace StiffOde
+{
+// Производные правой части по параметрам в точке (t, y): матрица n x p
+using ParameterJacobianFunction = std::function<Matrix(double t, const double* y)>;
+
+// Прямые чувствительности s_i = dy/dp_i удовлетворяют линейным уравнениям s_i' = J s_i + df/dp_i.
+// Неявная формула шага для них - та же, что для состояния: s - c (J s + df/dp) = rhs в конце шага, и решается
+// она после того, как найдено состояние (ступенчатая схема). Матрица итераций - (I - cJ) метода Ньютона
+// основного шага с её LU-разложением, поэтому p параметров стоят p обратных подстановок и произведений J s
+// на итерацию, а не p дополнительных решений. Невязка считается с J в конце шага: произведением на
+// Якобиан пользователя или разностной производной по направлению s, так что устаревший Якобиан
+// разложения влияет только на скорость сходимости, но не на результат.
+class SensitivityCorrector
+{
+public:
+    SensitivityCorrector(const InPlaceSystem& system, const JacobianFunction& jacobian,
+                         const ParameterJacobianFunction& parameterJacobian, Eigen::Index size,
+                         Eigen::Index parameters, size_t maxIterations);
+
+    // Правая часть уравнений чувствительности: derivatives.col(i) = J s_i + df/dp_i
+    void derivatives(double t, const Vector& y, const Matrix& s, Matrix& derivatives);
+    // s - начальное приближение и результат; rhs и s - n x p. Разложение newton должно быть получено
+    // с hGamma = c. scale - веса допусков для проверки сходимости, того же размера
+    bool solve(const NewtonSolver& newton, double t, const Vector& y, double c, const Matrix& rhs,
+               const Matrix& scale, Matrix& s);
+
+private:
+    // Якобиан пользователя (если задан) и df/dp в точке (t, y)
+    void load(double t, const Vector& y);
+    void multiply(double t, const Vector& y, const Matrix& s, Matrix& product);
+
+    const InPlaceSystem& m_system;
+    const JacobianFunction& m_jacobian;
+    const ParameterJacobianFunction& m_parameterJacobian;
+    size_t m_maxIterations;
+    double m_convergenceFactor {1.0};
+    std::vector<double> m_y;
+    Matrix m_jacobianMatrix;
+    Matrix m_parameterDerivatives;
+    Matrix m_product;
+    Matrix m_residual;
+    Vector m_perturbed;
+    Vector m_fForward;
+    Vector m_fBackward;
+    Vector m_delta;
+    Vector m_column;
+};
+}
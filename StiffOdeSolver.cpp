@@ -0,0 +1,1668 @@
+#include "StiffOdeSolver.hpp"
+#include "StiffOdeExponential.hpp"
+#include "StiffOdeNewton.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+
+namespace StiffOde
+{
+namespace
+{
+bool belowThreshold(const Vector& y, double stopThreshold)
+{
+    return stopThreshold > 0.0 && (y.array().abs() <= stopThreshold).all();
+}
+
+// Среднеквадратичная норма погрешности, взвешенная по atol + rtol * |y|
+double errorNorm(const Vector& error, const Vector& yOld, const Vector& yNew, double relTolerance, double absTolerance)
+{
+    return std::sqrt((error.array() / (absTolerance + relTolerance * yOld.array().abs().max(yNew.array().abs())))
+                         .square().sum() / static_cast<double>(error.size()));
+}
+
+void errorScale(const Vector& y, const SolverOptions& options, Vector& scale)
+{
+    scale = (options.absTolerance + options.relTolerance * y.array().abs()).matrix();
+}
+
+void errorScale(const Matrix& sensitivities, const SolverOptions& options, Matrix& scale)
+{
+    scale = (options.absTolerance + options.relTolerance * sensitivities.array().abs()).matrix();
+}
+
+double initialStepSize(const Vector& y, const Vector& f, const SolverOptions& options)
+{
+    const double d0 = errorNorm(y, y, y, options.relTolerance, options.absTolerance);
+    const double d1 = errorNorm(f, y, y, options.relTolerance, options.absTolerance);
+    return (d0 < 1e-5 || d1 < 1e-5) ? 1e-6 : 0.01 * d0 / d1;
+}
+
+#ifndef STIFF_ODE_NO_STATISTICS
+// Подсчёт операций линейной алгебры без изменения самих операций
+class CountingLinearSolver : public LinearSolver
+{
+public:
+    CountingLinearSolver(std::unique_ptr<LinearSolver> solver, SolverStatistics& statistics)
+        : m_solver(std::move(solver)), m_statistics(statistics)
+    {
+    }
+
+    void evaluateJacobian(double t, const Vector& y) override
+    {
+        ++m_statistics.jacobianEvaluations;
+        m_solver->evaluateJacobian(t, y);
+    }
+
+    void factorize(double hGamma) override
+    {
+        ++m_statistics.factorizations;
+        m_solver->factorize(hGamma);
+    }
+
+    void solve(const Vector& b, Vector& x) const override
+    {
+        ++m_statistics.linearSolves;
+        m_solver->solve(b, x);
+    }
+
+    void factorizeComplex(std::complex<double> hGamma) override
+    {
+        ++m_statistics.factorizations;
+        m_solver->factorizeComplex(hGamma);
+    }
+
+    void solveComplex(const ComplexVector& b, ComplexVector& x) const override
+    {
+        ++m_statistics.linearSolves;
+        m_solver->solveComplex(b, x);
+    }
+
+    void multiply(const Vector& v, Vector& result) const override
+    {
+        m_solver->multiply(v, result);
+    }
+
+    void denseJacobian(Matrix& jacobian) const override
+    {
+        m_solver->denseJacobian(jacobian);
+    }
+
+private:
+    std::unique_ptr<LinearSolver> m_solver;
+    SolverStatistics& m_statistics;
+};
+#endif
+
+const int maxBdfOrder = 5;
+
+using BdfMatrix = Eigen::Matrix<double, maxBdfOrder + 1, maxBdfOrder + 1>;
+
+// Матрица R(order, factor) пересчёта модифицированных разностей при изменении шага в factor раз
+BdfMatrix bdfStepTransform(int order, double factor)
+{
+    BdfMatrix r = BdfMatrix::Zero();
+    r.row(0).setOnes();
+    for (int i = 1; i <= order; ++i) {
+        for (int j = 1; j <= order; ++j)
+            r(i, j) = (i - 1 - factor * j) / i;
+        r.row(i) = r.row(i).cwiseProduct(r.row(i - 1));
+    }
+    return r;
+}
+
+// Разности D_0..D_order для шага, умноженного на factor
+void rescaleBdfDifferences(Matrix& differences, Matrix& work, int order, double factor)
+{
+    const Eigen::Index k = order + 1;
+    const BdfMatrix r = bdfStepTransform(order, factor);
+    const BdfMatrix u = bdfStepTransform(order, 1.0);
+    BdfMatrix ru = BdfMatrix::Zero();
+    ru.topLeftCorner(k, k).noalias() = r.topLeftCorner(k, k) * u.topLeftCorner(k, k);
+
+    work.leftCols(k).noalias() = differences.leftCols(k) * ru.topLeftCorner(k, k);
+    differences.leftCols(k) = work.leftCols(k);
+}
+
+// Разности D_0..D_order, перенесённые на shift шагов назад при том же шаге: значения интерполяционного
+// многочлена P(t + s h) = sum_j C(s + j - 1, j) D_j в узлах s = -shift - i, i <= order, снова переводятся в разности
+void shiftBdfDifferences(Matrix& differences, Matrix& work, int order, double shift)
+{
+    const Eigen::Index k = order + 1;
+    BdfMatrix values = BdfMatrix::Zero();
+    for (Eigen::Index i = 0; i < k; ++i) {
+        const double s = -shift - static_cast<double>(i);
+        double coefficient = 1.0;
+        for (Eigen::Index j = 0; j < k; ++j) {
+            if (j > 0)
+                coefficient *= (s + static_cast<double>(j - 1)) / static_cast<double>(j);
+            values(j, i) = coefficient;
+        }
+    }
+
+    // Обратные разности значений в узле 0: D'_j = sum_i (-1)^i C(j, i) v_i
+    BdfMatrix differencing = BdfMatrix::Zero();
+    for (Eigen::Index j = 0; j < k; ++j) {
+        double binomial = 1.0;
+        for (Eigen::Index i = 0; i <= j; ++i) {
+            differencing(i, j) = i % 2 == 0 ? binomial : -binomial;
+            binomial *= static_cast<double>(j - i) / static_cast<double>(i + 1);
+        }
+    }
+
+    BdfMatrix transform = BdfMatrix::Zero();
+    transform.topLeftCorner(k, k).noalias() = values.topLeftCorner(k, k) * differencing.topLeftCorner(k, k);
+    work.leftCols(k).noalias() = differences.leftCols(k) * transform.topLeftCorner(k, k);
+    differences.leftCols(k) = work.leftCols(k);
+}
+
+// Граница области устойчивости метода Дорманда - Принса на отрицательной вещественной полуоси
+const double dormandPrinceStabilityBoundary = 3.3;
+// Принятых шагов BDF между оценками спектрального радиуса при автоматическом выборе метода
+const size_t stiffnessCheckInterval = 20;
+
+// Спектральный радиус Якобиана степенным методом на конечно-разностных произведениях
+// J v ~ (f(t, y + delta v) - f(t, y)) / delta. Вектор прошлой оценки служит начальным приближением
+// следующей, поэтому повторные оценки обычно сходятся за несколько итераций.
+class SpectralRadiusEstimator
+{
+public:
+    SpectralRadiusEstimator(const InPlaceSystem& system, Eigen::Index size)
+        : m_system(system), m_direction(size), m_perturbed(size), m_product(size)
+    {
+        // Вектор общего положения, не ортогональный ни одному собственному вектору в типичных задачах
+        for (Eigen::Index i = 0; i < size; ++i)
+            m_direction[i] = 1.0 + 0.5 * std::sin(static_cast<double>(i + 1));
+        m_direction.normalize();
+    }
+
+    double operator()(double t, const Vector& y, const Vector& f)
+    {
+        const int maxIterations = 20;
+        const double relTolerance = 0.05;
+        const double delta = std::sqrt(std::numeric_limits<double>::epsilon()) * (1.0 + y.norm());
+
+        double previous = 0.0;
+        double radius = 0.0;
+        for (int i = 0; i < maxIterations; ++i) {
+            m_perturbed.noalias() = y + delta * m_direction;
+            evaluate(m_system, t, m_perturbed, m_product);
+            m_product -= f;
+            const double current = m_product.norm() / delta;
+            if (!(current > 0.0) || !std::isfinite(current))
+                return current;
+            m_direction = m_product / (current * delta);
+            if (std::abs(current - previous) <= relTolerance * current)
+                return current;
+            // Для пары комплексных собственных значений оценка колеблется; берётся большая из двух последних
+            radius = std::max(current, previous);
+            previous = current;
+        }
+        return radius;
+    }
+
+private:
+    const InPlaceSystem& m_system;
+    Vector m_direction;
+    Vector m_perturbed;
+    Vector m_product;
+};
+}
+
+StiffOdeSolver::StiffOdeSolver(const System& system)
+    : m_system(system)
+{
+}
+
+void StiffOdeSolver::setSystem(const System& system)
+{
+    m_system = system;
+    m_inPlaceSystem = {};
+}
+
+const System& StiffOdeSolver::system() const
+{
+    return m_system;
+}
+
+void StiffOdeSolver::setInPlaceSystem(const InPlaceSystem& system)
+{
+    m_inPlaceSystem = system;
+    m_system = {};
+}
+
+const InPlaceSystem& StiffOdeSolver::inPlaceSystem() const
+{
+    return m_inPlaceSystem;
+}
+
+void StiffOdeSolver::setJacobian(const JacobianFunction& jacobian)
+{
+    m_jacobian = jacobian;
+}
+
+const JacobianFunction& StiffOdeSolver::jacobian() const
+{
+    return m_jacobian;
+}
+
+void StiffOdeSolver::setSparseJacobian(const SparseJacobianFunction& jacobian)
+{
+    m_sparseJacobian = jacobian;
+}
+
+void StiffOdeSolver::setJacobianStructure(const JacobianStructure& structure)
+{
+    m_jacobianStructure = structure;
+}
+
+const JacobianStructure& StiffOdeSolver::jacobianStructure() const
+{
+    return m_jacobianStructure;
+}
+
+void StiffOdeSolver::setProgressCallback(const ProgressCallback& callback)
+{
+    m_progress = callback;
+}
+
+void StiffOdeSolver::setOutputCallback(const OutputCallback& callback)
+{
+    m_output = callback;
+}
+
+void StiffOdeSolver::setMethodSwitchCallback(const MethodSwitchCallback& callback)
+{
+    m_methodSwitch = callback;
+}
+
+void StiffOdeSolver::setCheckpointCallback(const CheckpointCallback& callback)
+{
+    m_checkpointCallback = callback;
+}
+
+void StiffOdeSolver::setEvents(const std::vector<Event>& events)
+{
+    m_events = events;
+}
+
+void StiffOdeSolver::setSensitivities(const ParameterJacobianFunction& parameterJacobian,
+                                      const Matrix& initialSensitivities)
+{
+    m_parameterJacobian = parameterJacobian;
+    m_initialSensitivities = parameterJacobian ? initialSensitivities : Matrix();
+}
+
+size_t StiffOdeSolver::sensitivityParameterCount() const
+{
+    return static_cast<size_t>(m_initialSensitivities.cols());
+}
+
+const std::vector<Event>& StiffOdeSolver::events() const
+{
+    return m_events;
+}
+
+void StiffOdeSolver::setOptions(const SolverOptions& options)
+{
+    m_options = options;
+}
+
+const SolverOptions& StiffOdeSolver::options() const
+{
+    return m_options;
+}
+
+SolveResult StiffOdeSolver::solve(const std::vector<double>& initialConditions, double startTime, double endTime,
+                                  Trajectory& trajectory) const
+{
+    trajectory.reset(initialConditions.size());
+
+    SolverCheckpoint state;
+    state.method = m_options.method;
+    state.t = startTime;
+    state.y = Eigen::Map<const Vector>(initialConditions.data(), static_cast<Eigen::Index>(initialConditions.size()));
+    if (sensitivitiesSupported() && m_initialSensitivities.rows() == state.y.size())
+        state.sensitivities = m_initialSensitivities;
+    m_sensitivityTrajectory.reset(static_cast<size_t>(state.sensitivities.size()));
+
+    if ((!m_system && !m_inPlaceSystem) || initialConditions.empty()) {
+        m_statistics = SolverStatistics();
+        m_eventOccurrences.clear();
+        m_checkpoint = state;
+        return { SolveStatus::Finished, startTime };
+    }
+
+    output(trajectory, state.t, state.y);
+    outputSensitivities(state.t, state.sensitivities);
+    return integrate(state, endTime, trajectory);
+}
+
+SolveResult StiffOdeSolver::resume(const SolverCheckpoint& checkpoint, double endTime, Trajectory& trajectory) const
+{
+    const size_t n = static_cast<size_t>(checkpoint.y.size());
+    SolverCheckpoint state = checkpoint;
+    if (state.method != m_options.method) {
+        state.method = m_options.method;
+        state.order = 0;
+        state.history.resize(0, 0);
+        state.sensitivityHistory.resize(0, 0);
+        state.stiff = false;
+    }
+    // Чувствительности продолжаются, только если они есть в контрольной точке для того же числа параметров
+    if (!sensitivitiesSupported() || state.sensitivities.rows() != checkpoint.y.size()
+        || state.sensitivities.cols() != m_initialSensitivities.cols() || m_initialSensitivities.cols() == 0) {
+        state.sensitivities.resize(0, 0);
+        state.sensitivityHistory.resize(0, 0);
+    }
+    m_sensitivityTrajectory.reset(static_cast<size_t>(state.sensitivities.size()));
+
+    if ((!m_system && !m_inPlaceSystem) || n == 0) {
+        m_statistics = SolverStatistics();
+        m_eventOccurrences.clear();
+        m_checkpoint = state;
+        return { SolveStatus::Finished, state.t };
+    }
+
+    // Контрольная точка уже записана в траекторию, к которой дописывается продолжение
+    if (trajectory.numComponents() != n || trajectory.empty()) {
+        trajectory.reset(n);
+        output(trajectory, state.t, state.y);
+        outputSensitivities(state.t, state.sensitivities);
+    }
+    return integrate(state, endTime, trajectory);
+}
+
+const SolverCheckpoint& StiffOdeSolver::checkpoint() const
+{
+    return m_checkpoint;
+}
+
+SolveResult StiffOdeSolver::integrate(SolverCheckpoint& state, double endTime, Trajectory& trajectory) const
+{
+    m_statistics = SolverStatistics();
+    m_eventLocator.reset();
+    m_eventOccurrences.clear();
+
+    const Eigen::Index n = state.y.size();
+    InPlaceSystem system = m_inPlaceSystem ? m_inPlaceSystem
+                                           : StiffOde::inPlaceSystem(m_system, static_cast<size_t>(n));
+#ifndef STIFF_ODE_NO_STATISTICS
+    // Все вычисления правой части, в том числе для конечно-разностного Якобиана, проходят через счётчик
+    system = [evaluations = &m_statistics.rhsEvaluations, rhs = std::move(system)](double t, const double* y,
+                                                                                   double* dydt)
+    {
+        ++*evaluations;
+        rhs(t, y, dydt);
+    };
+#endif
+
+    if (!m_events.empty()) {
+        m_eventLocator.emplace(m_events, system, n);
+        m_eventLocator->start(state.t, state.y);
+    }
+
+    SolveResult result;
+    switch (m_options.method) {
+    case Method::TrBdf2:
+        result = solveTrBdf2(system, state, endTime, trajectory);
+        break;
+    case Method::Bdf:
+        result = solveBdf(system, state, endTime, trajectory);
+        break;
+    case Method::Radau5:
+        result = solveRadau5(system, state, endTime, trajectory);
+        break;
+    case Method::ExponentialRosenbrock:
+        result = solveExponentialRosenbrock(system, state, endTime, trajectory);
+        break;
+    case Method::Automatic:
+        result = solveAutomatic(system, state, endTime, trajectory);
+        break;
+    case Method::BackwardEuler:
+        result = solveBackwardEuler(system, state, endTime, trajectory);
+        break;
+    }
+
+    count(m_statistics.acceptedSteps, result.acceptedSteps);
+    count(m_statistics.rejectedSteps, result.rejectedSteps);
+    m_eventLocator.reset();
+    m_checkpoint = state;
+    return result;
+}
+
+DenseOutput StiffOdeSolver::denseOutput(const TrajectoryData& trajectory) const
+{
+    switch (m_options.method) {
+    case Method::TrBdf2:
+    case Method::Bdf:
+    case Method::Radau5:
+    case Method::ExponentialRosenbrock:
+    case Method::Automatic:
+        if (m_inPlaceSystem)
+            return DenseOutput(trajectory, m_inPlaceSystem);
+        if (m_system)
+            return DenseOutput(trajectory, StiffOde::inPlaceSystem(m_system, trajectory.numComponents()));
+        break;
+    case Method::BackwardEuler:
+        break;
+    }
+    return DenseOutput(trajectory);
+}
+
+const SolverStatistics& StiffOdeSolver::statistics() const
+{
+    return m_statistics;
+}
+
+const std::vector<EventOccurrence>& StiffOdeSolver::eventOccurrences() const
+{
+    return m_eventOccurrences;
+}
+
+const Trajectory& StiffOdeSolver::sensitivityTrajectory() const
+{
+    return m_sensitivityTrajectory;
+}
+
+std::unique_ptr<LinearSolver> StiffOdeSolver::createLinearSolver(const InPlaceSystem& system, size_t size) const
+{
+    std::unique_ptr<LinearSolver> solver = StiffOde::createLinearSolver(system, m_jacobian, m_sparseJacobian,
+                                                                        m_jacobianStructure,
+                                                                        static_cast<Eigen::Index>(size));
+#ifndef STIFF_ODE_NO_STATISTICS
+    return std::make_unique<CountingLinearSolver>(std::move(solver), m_statistics);
+#else
+    return solver;
+#endif
+}
+
+void StiffOdeSolver::output(Trajectory& trajectory, double t, const Vector& y) const
+{
+    if (m_options.storeTrajectory)
+        trajectory.append(t, y.data());
+    if (m_output)
+        m_output(t, y.data());
+}
+
+bool StiffOdeSolver::terminalEvent(double& t, Vector& y) const
+{
+    return m_eventLocator && m_eventLocator->step(t, y, m_eventOccurrences);
+}
+
+bool StiffOdeSolver::sensitivitiesSupported() const
+{
+    return m_parameterJacobian
+           && (m_options.method == Method::BackwardEuler || m_options.method == Method::Bdf);
+}
+
+void StiffOdeSolver::outputSensitivities(double t, const Matrix& sensitivities) const
+{
+    if (m_options.storeTrajectory && sensitivities.size() > 0)
+        m_sensitivityTrajectory.append(t, sensitivities.data());
+}
+
+void StiffOdeSolver::notifyCheckpoint(const SolverCheckpoint& state, size_t acceptedSteps) const
+{
+    if (m_checkpointCallback && m_options.checkpointInterval > 0 && acceptedSteps % m_options.checkpointInterval == 0)
+        m_checkpointCallback(state);
+}
+
+SolveResult StiffOdeSolver::solveBackwardEuler(const InPlaceSystem& system, SolverCheckpoint& state, double endTime,
+                                               Trajectory& trajectory) const
+{
+    const double stepSize = m_options.stepSize;
+    size_t currentStep = 0;
+
+    double& t = state.t;
+    Vector& y = state.y;
+    state.h = stepSize;
+
+    // Узлы отсчитываются от начала этого счёта, при продолжении - от контрольной точки
+    const double origin = t;
+    const size_t steps = fixedStepCount(origin, endTime, stepSize);
+    if (m_options.storeTrajectory)
+        trajectory.reserve(trajectory.size() + std::min(steps, m_options.maxSteps));
+
+    const Eigen::Index n = y.size();
+    Vector yNext(n);
+    Vector scale(n);
+
+    NewtonSolver newton(system, createLinearSolver(system, static_cast<size_t>(n)), n, m_options.maxNewtonIterations);
+    newton.setStatistics(&m_statistics);
+
+    // Чувствительности: (I - hJ) s_{n+1} - h df/dp = s_n с тем же разложением, что и у шага по y
+    Matrix& sensitivities = state.sensitivities;
+    const Eigen::Index parameters = sensitivities.cols();
+    SensitivityCorrector corrector(system, m_jacobian, m_parameterJacobian, n, parameters,
+                                   m_options.maxNewtonIterations);
+    Matrix sensitivitiesNext(n, parameters);
+    Matrix sensitivityScale(n, parameters);
+
+    while (currentStep < steps) {
+        // Проверка порогового значения
+        if (belowThreshold(y, m_options.stopThreshold))
+            return { SolveStatus::BelowThreshold, t, currentStep };
+
+        if (currentStep >= m_options.maxSteps)
+            return { SolveStatus::MaxStepsExceeded, t, currentStep };
+
+        // Вычисляем следующее значение
+        const double tNext = fixedStepTime(origin, endTime, stepSize, currentStep + 1);
+
+        // Решаем систему y_{n+1} - h f(y_{n+1}) = y_n методом Ньютона
+        errorScale(y, m_options, scale);
+        yNext = y;
+        newton.prepare(t, y, stepSize);
+        if (!newton.solve(tNext, y, scale, yNext)) {
+            if (newton.jacobianCurrent())
+                return { SolveStatus::NewtonFailure, t, currentStep };
+
+            // Повтор со свежим Якобианом
+            yNext = y;
+            newton.prepare(t, y, stepSize);
+            if (!newton.solve(tNext, y, scale, yNext))
+                return { SolveStatus::NewtonFailure, t, currentStep };
+        }
+
+        if (parameters > 0) {
+            errorScale(sensitivities, m_options, sensitivityScale);
+            sensitivitiesNext = sensitivities;
+            if (!corrector.solve(newton, tNext, yNext, stepSize, sensitivities, sensitivityScale, sensitivitiesNext)) {
+                // Повтор с Якобианом в конце шага
+                newton.invalidateJacobian();
+                newton.prepare(tNext, yNext, stepSize);
+                sensitivitiesNext = sensitivities;
+                if (!corrector.solve(newton, tNext, yNext, stepSize, sensitivities, sensitivityScale,
+                                     sensitivitiesNext))
+                    return { SolveStatus::NewtonFailure, t, currentStep };
+            }
+        }
+
+        const double tPrevious = t;
+        y.swap(yNext);
+        t = tNext;
+        ++currentStep;
+
+        // Записываем новую точку в траекторию
+        const bool terminal = terminalEvent(t, y);
+        if (parameters > 0) {
+            // В точке терминального события чувствительности интерполируются линейно внутри шага
+            if (terminal)
+                sensitivitiesNext = sensitivities + (t - tPrevious) / stepSize * (sensitivitiesNext - sensitivities);
+            sensitivities.swap(sensitivitiesNext);
+        }
+        output(trajectory, t, y);
+        outputSensitivities(t, sensitivities);
+        if (terminal)
+            return { SolveStatus::TerminalEvent, t, currentStep };
+
+        if (m_progress && !m_progress(t))
+            return { SolveStatus::Cancelled, t, currentStep };
+        notifyCheckpoint(state, currentStep);
+    }
+
+    return { SolveStatus::Finished, t, currentStep };
+}
+
+// TR-BDF2 (Hosea, Shampine, 1996) в форме ESDIRK: трапеции на [t, t + gamma*h], затем BDF2 на [t, t + h].
+// Обе стадии используют одну матрицу (I - d*h*J); вложенная формула третьего порядка даёт оценку погрешности,
+// которая дополнительно сглаживается той же матрицей, чтобы не завышаться на жёстких компонентах.
+SolveResult StiffOdeSolver::solveTrBdf2(const InPlaceSystem& system, SolverCheckpoint& state, double endTime,
+                                        Trajectory& trajectory) const
+{
+    const double gamma = 2.0 - std::sqrt(2.0);
+    const double d = gamma / 2.0;
+    const double w = std::sqrt(2.0) / 4.0;
+    const double e1 = w - (1.0 - w) / 3.0;
+    const double e2 = w - (3.0 * w + 1.0) / 3.0;
+    const double e3 = 2.0 * d / 3.0;
+
+    const double safety = 0.9;
+    const double minFactor = 0.2;
+    const double maxFactor = 5.0;
+    // Небольшое увеличение шага не стоит нового LU-разложения
+    const double keepStepFactor = 1.2;
+    // Оценка погрешности строится из k2, k3 и f(y), то есть из решений итераций Ньютона; их погрешность
+    // попадает в оценку с множителем порядка 1/d, поэтому итерации сходятся на порядок точнее,
+    // чем требует общий допуск 0.03, иначе при малых допусках оценка не опускается ниже 1 и шаг застревает
+    const double newtonTolerance = 0.003;
+
+    const Eigen::Index n = state.y.size();
+
+    SolveResult result;
+    double& t = state.t;
+    Vector& y = state.y;
+    Vector f(n);
+    evaluate(system, t, y, f);
+
+    // Рабочие векторы шага
+    Vector scale(n);
+    Vector rhs2(n);
+    Vector rhs3(n);
+    Vector z2(n);
+    Vector z3(n);
+    Vector k2(n);
+    Vector k3(n);
+    Vector work(n);
+    Vector error(n);
+
+    double& h = state.h;
+    if (h <= 0.0)
+        h = m_options.stepSize > 0.0 ? m_options.stepSize : initialStepSize(y, f, m_options);
+    bool rejectedLast = false;
+
+    NewtonSolver newton(system, createLinearSolver(system, static_cast<size_t>(n)), n, m_options.maxNewtonIterations);
+    newton.setStatistics(&m_statistics);
+    newton.setTolerance(newtonTolerance);
+
+    while (t < endTime) {
+        if (belowThreshold(y, m_options.stopThreshold))
+            return { SolveStatus::BelowThreshold, t, result.acceptedSteps, result.rejectedSteps };
+
+        if (result.acceptedSteps + result.rejectedSteps >= m_options.maxSteps)
+            return { SolveStatus::MaxStepsExceeded, t, result.acceptedSteps, result.rejectedSteps };
+
+        if (m_options.maxStepSize > 0.0)
+            h = std::min(h, m_options.maxStepSize);
+
+        // Не оставляем в конце отрезка шаг, меньший минимального
+        const double remaining = endTime - t;
+        if (h >= remaining || remaining - h < m_options.minStepSize)
+            h = remaining;
+
+        if (h < m_options.minStepSize)
+            return { SolveStatus::StepSizeTooSmall, t, result.acceptedSteps, result.rejectedSteps };
+
+        newton.prepare(t, y, d * h);
+        errorScale(y, m_options, scale);
+
+        // Стадия трапеций: z2 - d*h*f(z2) = y + d*h*f
+        rhs2.noalias() = y + d * h * f;
+        z2 = y;
+        bool converged = newton.solve(t + gamma * h, rhs2, scale, z2);
+
+        // Стадия BDF2: z3 - d*h*f(z3) = y + w*h*(f + k2), прогноз - линейная экстраполяция через y и z2
+        if (converged) {
+            k2.noalias() = (z2 - rhs2) / (d * h);
+            rhs3.noalias() = y + w * h * (f + k2);
+            z3.noalias() = y + (z2 - y) / gamma;
+            converged = newton.solve(t + h, rhs3, scale, z3);
+        }
+
+        if (!converged) {
+            // Сначала обновляем Якобиан при том же шаге, затем уменьшаем шаг
+            if (!newton.jacobianCurrent())
+                continue;
+
+            ++result.rejectedSteps;
+            rejectedLast = true;
+            h *= 0.25;
+            continue;
+        }
+
+        k3.noalias() = (z3 - rhs3) / (d * h);
+
+        work.noalias() = h * (e1 * f + e2 * k2 + e3 * k3);
+        newton.solveLinear(work, error);
+        const double norm = errorNorm(error, y, z3, m_options.relTolerance, m_options.absTolerance);
+
+        double factor = norm > 0.0 ? safety * std::pow(norm, -1.0 / 3.0) : maxFactor;
+        factor = std::clamp(factor, minFactor, rejectedLast ? 1.0 : maxFactor);
+        if (factor >= 1.0 && factor < keepStepFactor)
+            factor = 1.0;
+
+        if (norm <= 1.0) {
+            t = (h == remaining) ? endTime : t + h;
+            y.swap(z3);
+            evaluate(system, t, y, f);
+            const bool terminal = terminalEvent(t, y);
+            output(trajectory, t, y);
+            ++result.acceptedSteps;
+            rejectedLast = false;
+
+            if (terminal)
+                return { SolveStatus::TerminalEvent, t, result.acceptedSteps, result.rejectedSteps };
+            if (m_progress && !m_progress(t))
+                return { SolveStatus::Cancelled, t, result.acceptedSteps, result.rejectedSteps };
+            notifyCheckpoint(state, result.acceptedSteps);
+        }
+        else {
+            ++result.rejectedSteps;
+            rejectedLast = true;
+        }
+
+        h *= factor;
+    }
+
+    return { SolveStatus::Finished, t, result.acceptedSteps, result.rejectedSteps };
+}
+
+// BDF переменного порядка 1-5 и переменного шага в форме модифицированных разностей D_0..D_{k+2}
+// (Shampine, Reichelt, 1997; выбор порядка как в ode15s). Порядок и шаг пересматриваются не раньше,
+// чем через order + 1 шагов постоянной длины; как в CVODE, шаг не меняется ради увеличения меньше чем
+// в keepStepFactor раз, и тогда разложение (I - h/alpha_k J) сохраняется между шагами.
+SolveResult StiffOdeSolver::solveBdf(const InPlaceSystem& system, SolverCheckpoint& state, double endTime,
+                                     Trajectory& trajectory) const
+{
+    SolveResult result;
+    advanceBdf(system, endTime, trajectory, state, result, false);
+    return result;
+}
+
+// Автоматический выбор метода по жёсткости, как в LSODA (Petzold, 1983). Счёт начинается явным методом
+// Дорманда - Принса; при устойчиво большом h |lambda| он уступает место BDF. На участке BDF спектральный
+// радиус Якобиана периодически оценивается степенным методом, и если явный метод устойчив при текущем
+// шаге с запасом, счёт возвращается к нему. Обоим методам нужна только правая часть системы.
+SolveResult StiffOdeSolver::solveAutomatic(const InPlaceSystem& system, SolverCheckpoint& state, double endTime,
+                                           Trajectory& trajectory) const
+{
+    SolveResult result;
+    while (!(state.stiff ? advanceBdf(system, endTime, trajectory, state, result, true)
+                         : advanceDormandPrince(system, endTime, trajectory, state, result, true))) {
+        // История BDF не переживает участок явного метода
+        state.stiff = !state.stiff;
+        state.order = 0;
+        count(m_statistics.methodSwitches);
+        if (m_methodSwitch)
+            m_methodSwitch(state.t, state.stiff);
+    }
+    return result;
+}
+
+bool StiffOdeSolver::advanceBdf(const InPlaceSystem& system, double endTime, Trajectory& trajectory,
+                                SolverCheckpoint& state, SolveResult& result, bool detectSwitch) const
+{
+    const double minFactor = 0.2;
+    const double maxFactor = 10.0;
+    const double keepStepFactor = 1.2;
+    const double maxIterations = static_cast<double>(m_options.maxNewtonIterations);
+
+    // gamma_k = 1 + 1/2 + ... + 1/k; константа погрешности порядка k - 1/(k + 1)
+    Eigen::Matrix<double, maxBdfOrder + 2, 1> gammas;
+    gammas[0] = 0.0;
+    for (int k = 1; k <= maxBdfOrder + 1; ++k)
+        gammas[k] = gammas[k - 1] + 1.0 / k;
+    auto errorConstant = [](int order) { return 1.0 / (order + 1); };
+
+    double& t = state.t;
+    Vector& y = state.y;
+    double& h = state.h;
+    auto finish = [&result, &t](SolveStatus status)
+    {
+        result.status = status;
+        result.stopTime = t;
+        return true;
+    };
+
+    const Eigen::Index n = y.size();
+    Vector f(n);
+
+    // Разности D_0..D_{k+2}, порядок и счётчик шагов постоянной длины живут в state,
+    // чтобы счёт можно было продолжить из контрольной точки
+    Matrix& differences = state.history;
+    int& order = state.order;
+    size_t& equalSteps = state.equalSteps;
+
+    // Чувствительности интегрируются той же формулой с тем же шагом и порядком; их разности хранятся
+    // как разности вектора, составленного из столбцов s_1..s_p, и преобразуются вместе с разностями y
+    Matrix& sensitivities = state.sensitivities;
+    Matrix& sensitivityDifferences = state.sensitivityHistory;
+    const Eigen::Index parameters = sensitivities.cols();
+    const Eigen::Index sensitivitySize = n * parameters;
+    SensitivityCorrector corrector(system, m_jacobian, m_parameterJacobian, n, parameters,
+                                   m_options.maxNewtonIterations);
+    Matrix sensitivityDerivatives(n, parameters);
+    if (parameters > 0 && (sensitivityDifferences.rows() != sensitivitySize
+                           || sensitivityDifferences.cols() != maxBdfOrder + 3))
+        order = 0;
+
+    if (order < 1 || differences.rows() != n || differences.cols() != maxBdfOrder + 3) {
+        evaluate(system, t, y, f);
+        if (h <= 0.0)
+            h = m_options.stepSize > 0.0 ? m_options.stepSize : initialStepSize(y, f, m_options);
+        if (m_options.maxStepSize > 0.0)
+            h = std::min(h, m_options.maxStepSize);
+
+        differences = Matrix::Zero(n, maxBdfOrder + 3);
+        differences.col(0) = y;
+        differences.col(1) = h * f;
+        order = 1;
+        equalSteps = 0;
+
+        if (parameters > 0) {
+            corrector.derivatives(t, y, sensitivities, sensitivityDerivatives);
+            sensitivityDifferences = Matrix::Zero(sensitivitySize, maxBdfOrder + 3);
+            sensitivityDifferences.col(0) = Eigen::Map<const Vector>(sensitivities.data(), sensitivitySize);
+            sensitivityDifferences.col(1) = h * Eigen::Map<const Vector>(sensitivityDerivatives.data(),
+                                                                         sensitivitySize);
+        }
+    }
+
+    // Рабочие массивы шага
+    Matrix work(n, maxBdfOrder + 1);
+    Vector predicted(n);
+    Vector psi(n);
+    Vector rhs(n);
+    Vector z(n);
+    Vector correction(n);
+    Vector error(n);
+    Vector errorDown(n);
+    Vector errorUp(n);
+    Vector scale(n);
+    Matrix sensitivityWork(sensitivitySize, maxBdfOrder + 1);
+    Matrix predictedSensitivities(n, parameters);
+    Matrix sensitivityRhs(n, parameters);
+    Matrix correctedSensitivities(n, parameters);
+    Matrix sensitivityScale(n, parameters);
+    Eigen::Map<Vector> predictedSensitivitiesVector(predictedSensitivities.data(), sensitivitySize);
+    Eigen::Map<Vector> sensitivityRhsVector(sensitivityRhs.data(), sensitivitySize);
+    Eigen::Map<const Vector> correctedSensitivitiesVector(correctedSensitivities.data(), sensitivitySize);
+
+    // Пересчёт разностей y и чувствительностей под шаг h * factor
+    auto rescale = [&](double factor)
+    {
+        rescaleBdfDifferences(differences, work, order, factor);
+        if (parameters > 0)
+            rescaleBdfDifferences(sensitivityDifferences, sensitivityWork, order, factor);
+    };
+
+    SpectralRadiusEstimator spectralRadius(system, n);
+    size_t stepsSinceCheck = 0;
+
+    NewtonSolver newton(system, createLinearSolver(system, static_cast<size_t>(n)), n, m_options.maxNewtonIterations);
+    newton.setStatistics(&m_statistics);
+
+    while (t < endTime) {
+        if (belowThreshold(y, m_options.stopThreshold))
+            return finish(SolveStatus::BelowThreshold);
+
+        if (result.acceptedSteps + result.rejectedSteps >= m_options.maxSteps)
+            return finish(SolveStatus::MaxStepsExceeded);
+
+        // Ограничения шага и подход к концу отрезка; разности пересчитываются под новый шаг
+        double hNew = h;
+        if (m_options.maxStepSize > 0.0)
+            hNew = std::min(hNew, m_options.maxStepSize);
+        const double remaining = endTime - t;
+        if (hNew >= remaining || remaining - hNew < m_options.minStepSize)
+            hNew = remaining;
+
+        if (hNew < m_options.minStepSize)
+            return finish(SolveStatus::StepSizeTooSmall);
+
+        if (hNew != h) {
+            rescale(hNew / h);
+            h = hNew;
+            equalSteps = 0;
+        }
+
+        // Прогноз y_{n+1} = D_0 + ... + D_k; корректор y - h/alpha_k f(y) = прогноз - psi
+        predicted.noalias() = differences.leftCols(order + 1).rowwise().sum();
+        psi.noalias() = (1.0 / gammas[order]) * differences.middleCols(1, order) * gammas.segment(1, order);
+        rhs.noalias() = predicted - psi;
+        const double c = h / gammas[order];
+
+        errorScale(predicted, m_options, scale);
+        newton.prepare(t + h, predicted, c);
+        z = predicted;
+        bool converged = newton.solve(t + h, rhs, scale, z);
+        if (!converged && !newton.jacobianCurrent()) {
+            // Повтор со свежим Якобианом при том же шаге
+            newton.prepare(t + h, predicted, c);
+            z = predicted;
+            converged = newton.solve(t + h, rhs, scale, z);
+        }
+
+        if (!converged) {
+            ++result.rejectedSteps;
+            rescale(0.25);
+            h *= 0.25;
+            equalSteps = 0;
+            continue;
+        }
+
+        // Чем больше итераций потребовалось, тем осторожнее выбирается следующий шаг
+        const double safety = 0.9 * (2.0 * maxIterations + 1.0)
+                              / (2.0 * maxIterations + static_cast<double>(newton.iterations()));
+
+        correction.noalias() = z - predicted;
+        error.noalias() = errorConstant(order) * correction;
+        const double norm = errorNorm(error, z, z, m_options.relTolerance, m_options.absTolerance);
+
+        if (norm > 1.0) {
+            ++result.rejectedSteps;
+            const double factor = std::max(minFactor, safety * std::pow(norm, -1.0 / (order + 1)));
+            rescale(factor);
+            h *= factor;
+            equalSteps = 0;
+            continue;
+        }
+
+        // Чувствительности в конце принятого шага: та же формула с прогнозом и psi по их разностям
+        if (parameters > 0) {
+            predictedSensitivitiesVector.noalias() = sensitivityDifferences.leftCols(order + 1).rowwise().sum();
+            sensitivityRhsVector = predictedSensitivitiesVector;
+            sensitivityRhsVector.noalias() -= (1.0 / gammas[order]) * sensitivityDifferences.middleCols(1, order)
+                                              * gammas.segment(1, order);
+            errorScale(predictedSensitivities, m_options, sensitivityScale);
+            correctedSensitivities = predictedSensitivities;
+            if (!corrector.solve(newton, t + h, z, c, sensitivityRhs, sensitivityScale, correctedSensitivities)) {
+                ++result.rejectedSteps;
+                newton.invalidateJacobian();
+                rescale(0.25);
+                h *= 0.25;
+                equalSteps = 0;
+                continue;
+            }
+        }
+
+        const double tPrevious = t;
+        t = (h == remaining) ? endTime : t + h;
+        const double stepEnd = t;
+        y.swap(z);
+        ++result.acceptedSteps;
+        ++equalSteps;
+
+        differences.col(order + 2) = correction - differences.col(order + 1);
+        differences.col(order + 1) = correction;
+        for (int i = order; i >= 0; --i)
+            differences.col(i) += differences.col(i + 1);
+
+        if (parameters > 0) {
+            sensitivityDifferences.col(order + 2) = correctedSensitivitiesVector - predictedSensitivitiesVector
+                                                    - sensitivityDifferences.col(order + 1);
+            sensitivityDifferences.col(order + 1) = correctedSensitivitiesVector - predictedSensitivitiesVector;
+            for (int i = order; i >= 0; --i)
+                sensitivityDifferences.col(i) += sensitivityDifferences.col(i + 1);
+        }
+
+        const bool terminal = terminalEvent(t, y);
+        if (parameters > 0) {
+            // В точке терминального события чувствительности интерполируются линейно внутри шага
+            if (terminal)
+                sensitivities += (t - tPrevious) / h * (correctedSensitivities - sensitivities);
+            else
+                sensitivities = correctedSensitivities;
+        }
+        output(trajectory, t, y);
+        outputSensitivities(t, sensitivities);
+        if (terminal) {
+            // Конечное состояние - точка события: разности переносятся в неё, чтобы продолжение
+            // из контрольной точки шло от события, а не от конца шага
+            shiftBdfDifferences(differences, work, order, (stepEnd - t) / h);
+            const Vector offset = y - differences.col(0);
+            differences.leftCols(order + 1).colwise() += offset;
+            if (parameters > 0) {
+                shiftBdfDifferences(sensitivityDifferences, sensitivityWork, order, (stepEnd - t) / h);
+                const Vector sensitivityOffset = Eigen::Map<const Vector>(sensitivities.data(), sensitivitySize)
+                                                 - sensitivityDifferences.col(0);
+                sensitivityDifferences.leftCols(order + 1).colwise() += sensitivityOffset;
+            }
+            equalSteps = 0;
+            return finish(SolveStatus::TerminalEvent);
+        }
+        if (m_progress && !m_progress(t))
+            return finish(SolveStatus::Cancelled);
+        notifyCheckpoint(state, result.acceptedSteps);
+
+        // Явный метод выгоднее, если он устойчив при текущем шаге с двукратным запасом
+        if (detectSwitch && t < endTime && ++stepsSinceCheck >= stiffnessCheckInterval) {
+            stepsSinceCheck = 0;
+            evaluate(system, t, y, f);
+            if (h * spectralRadius(t, y, f) < 0.5 * dormandPrinceStabilityBoundary)
+                return false;
+        }
+
+        if (equalSteps < static_cast<size_t>(order) + 1)
+            continue;
+
+        // Оценки погрешности для порядков order - 1, order и order + 1
+        const double infinity = std::numeric_limits<double>::infinity();
+        double normDown = infinity;
+        if (order > 1) {
+            errorDown.noalias() = errorConstant(order - 1) * differences.col(order);
+            normDown = errorNorm(errorDown, y, y, m_options.relTolerance, m_options.absTolerance);
+        }
+        double normUp = infinity;
+        if (order < maxBdfOrder) {
+            errorUp.noalias() = errorConstant(order + 1) * differences.col(order + 2);
+            normUp = errorNorm(errorUp, y, y, m_options.relTolerance, m_options.absTolerance);
+        }
+
+        const double factors[] = { std::pow(normDown, -1.0 / order), std::pow(norm, -1.0 / (order + 1)),
+                                   std::pow(normUp, -1.0 / (order + 2)) };
+        const int best = static_cast<int>(std::max_element(std::begin(factors), std::end(factors)) - factors);
+        const int deltaOrder = best - 1;
+        const double factor = std::min(maxFactor, safety * factors[best]);
+
+        if (deltaOrder == 0 && factor >= 1.0 && factor < keepStepFactor)
+            continue;
+
+        order += deltaOrder;
+        rescale(factor);
+        h *= factor;
+        equalSteps = 0;
+    }
+
+    return finish(SolveStatus::Finished);
+}
+
+// Явный метод Дорманда - Принса 5(4) с FSAL и продолжением по решению пятого порядка. Жёсткость
+// определяется как в DOPRI5 (Hairer, Wanner): h |lambda| ~ h |k7 - k6| / |y1 - y6|, где k6 и k7 -
+// производные в двух точках на конце шага; 15 принятых шагов у границы устойчивости подряд (с прощением
+// после 6 спокойных) означают, что шаг ограничен устойчивостью, а не точностью.
+bool StiffOdeSolver::advanceDormandPrince(const InPlaceSystem& system, double endTime, Trajectory& trajectory,
+                                          SolverCheckpoint& state, SolveResult& result, bool detectSwitch) const
+{
+    const double c2 = 1.0 / 5.0, c3 = 3.0 / 10.0, c4 = 4.0 / 5.0, c5 = 8.0 / 9.0;
+    const double a21 = 1.0 / 5.0;
+    const double a31 = 3.0 / 40.0, a32 = 9.0 / 40.0;
+    const double a41 = 44.0 / 45.0, a42 = -56.0 / 15.0, a43 = 32.0 / 9.0;
+    const double a51 = 19372.0 / 6561.0, a52 = -25360.0 / 2187.0, a53 = 64448.0 / 6561.0, a54 = -212.0 / 729.0;
+    const double a61 = 9017.0 / 3168.0, a62 = -355.0 / 33.0, a63 = 46732.0 / 5247.0, a64 = 49.0 / 176.0,
+                 a65 = -5103.0 / 18656.0;
+    const double a71 = 35.0 / 384.0, a73 = 500.0 / 1113.0, a74 = 125.0 / 192.0, a75 = -2187.0 / 6784.0,
+                 a76 = 11.0 / 84.0;
+    const double e1 = 71.0 / 57600.0, e3 = -71.0 / 16695.0, e4 = 71.0 / 1920.0, e5 = -17253.0 / 339200.0,
+                 e6 = 22.0 / 525.0, e7 = -1.0 / 40.0;
+
+    const double safety = 0.9;
+    const double minFactor = 0.2;
+    const double maxFactor = 10.0;
+    const double beta = 0.04;
+    // Чуть меньше границы устойчивости: у неё шаг и держит регулятор на жёстком участке
+    const double stiffHLambda = 3.25;
+    const size_t stiffStepsToSwitch = 15;
+    const size_t nonStiffStepsToForgive = 6;
+
+    double& t = state.t;
+    Vector& y = state.y;
+    double& h = state.h;
+    auto finish = [&result, &t](SolveStatus status)
+    {
+        result.status = status;
+        result.stopTime = t;
+        return true;
+    };
+
+    const Eigen::Index n = y.size();
+    Vector k1(n), k2(n), k3(n), k4(n), k5(n), k6(n), k7(n);
+    Vector stage(n);
+    Vector y6(n);
+    Vector yNew(n);
+    Vector error(n);
+    evaluate(system, t, y, k1);
+    if (h <= 0.0)
+        h = m_options.stepSize > 0.0 ? m_options.stepSize : initialStepSize(y, k1, m_options);
+
+    bool rejectedLast = false;
+    double previousNorm = 1e-4;
+    size_t stiffSteps = 0;
+    size_t nonStiffSteps = 0;
+
+    while (t < endTime) {
+        if (belowThreshold(y, m_options.stopThreshold))
+            return finish(SolveStatus::BelowThreshold);
+
+        if (result.acceptedSteps + result.rejectedSteps >= m_options.maxSteps)
+            return finish(SolveStatus::MaxStepsExceeded);
+
+        if (m_options.maxStepSize > 0.0)
+            h = std::min(h, m_options.maxStepSize);
+
+        const double remaining = endTime - t;
+        if (h >= remaining || remaining - h < m_options.minStepSize)
+            h = remaining;
+
+        if (h < m_options.minStepSize)
+            return finish(SolveStatus::StepSizeTooSmall);
+
+        stage.noalias() = y + h * a21 * k1;
+        evaluate(system, t + c2 * h, stage, k2);
+        stage.noalias() = y + h * (a31 * k1 + a32 * k2);
+        evaluate(system, t + c3 * h, stage, k3);
+        stage.noalias() = y + h * (a41 * k1 + a42 * k2 + a43 * k3);
+        evaluate(system, t + c4 * h, stage, k4);
+        stage.noalias() = y + h * (a51 * k1 + a52 * k2 + a53 * k3 + a54 * k4);
+        evaluate(system, t + c5 * h, stage, k5);
+        y6.noalias() = y + h * (a61 * k1 + a62 * k2 + a63 * k3 + a64 * k4 + a65 * k5);
+        evaluate(system, t + h, y6, k6);
+        yNew.noalias() = y + h * (a71 * k1 + a73 * k3 + a74 * k4 + a75 * k5 + a76 * k6);
+        evaluate(system, t + h, yNew, k7);
+
+        error.noalias() = h * (e1 * k1 + e3 * k3 + e4 * k4 + e5 * k5 + e6 * k6 + e7 * k7);
+        const double norm = errorNorm(error, y, yNew, m_options.relTolerance, m_options.absTolerance);
+
+        // PI-регулятор DOPRI5 с показателями 1/5 - 0.75 beta и beta
+        double factor = norm > 0.0 ? safety * std::pow(norm, -(0.2 - 0.75 * beta)) * std::pow(previousNorm, beta)
+                                   : maxFactor;
+        factor = std::clamp(factor, minFactor, rejectedLast ? 1.0 : maxFactor);
+
+        if (norm > 1.0) {
+            ++result.rejectedSteps;
+            rejectedLast = true;
+            h *= factor;
+            continue;
+        }
+
+        const double denominator = (yNew - y6).squaredNorm();
+        const double hLambda = denominator > 0.0 ? h * std::sqrt((k7 - k6).squaredNorm() / denominator) : 0.0;
+
+        t = (h == remaining) ? endTime : t + h;
+        y.swap(yNew);
+        k1.swap(k7);
+        const bool terminal = terminalEvent(t, y);
+        output(trajectory, t, y);
+        ++result.acceptedSteps;
+        rejectedLast = false;
+        previousNorm = std::max(norm, 1e-4);
+
+        if (terminal)
+            return finish(SolveStatus::TerminalEvent);
+        if (m_progress && !m_progress(t))
+            return finish(SolveStatus::Cancelled);
+        notifyCheckpoint(state, result.acceptedSteps);
+
+        h *= factor;
+
+        if (!detectSwitch)
+            continue;
+        if (hLambda > stiffHLambda) {
+            nonStiffSteps = 0;
+            if (++stiffSteps >= stiffStepsToSwitch && t < endTime)
+                return false;
+        }
+        else if (++nonStiffSteps >= nonStiffStepsToForgive) {
+            stiffSteps = 0;
+        }
+    }
+
+    return finish(SolveStatus::Finished);
+}
+
+// Radau IIA с тремя стадиями (Hairer, Wanner; RADAU5). Система стадий размера 3N заменой переменных
+// W = T^-1 Z приводится к одной вещественной системе с матрицей (I - h/u1 J) и одной комплексной
+// с (I - h/(alpha + i beta) J), где u1 и alpha +- i beta - собственные значения обратной матрицы метода.
+// Якобиан и оба разложения переиспользуются, пока Ньютон сходится быстро, а шаг не меняется;
+// шаг выбирается предсказывающим регулятором Густафссона.
+SolveResult StiffOdeSolver::solveRadau5(const InPlaceSystem& system, SolverCheckpoint& state, double endTime,
+                                        Trajectory& trajectory) const
+{
+    const double sq6 = std::sqrt(6.0);
+    const double c1 = (4.0 - sq6) / 10.0;
+    const double c2 = (4.0 + sq6) / 10.0;
+    const double c1m1 = c1 - 1.0;
+    const double c2m1 = c2 - 1.0;
+    const double c1mc2 = c1 - c2;
+    const double dd1 = -(13.0 + 7.0 * sq6) / 3.0;
+    const double dd2 = (-13.0 + 7.0 * sq6) / 3.0;
+    const double dd3 = -1.0 / 3.0;
+
+    const double cbrt81 = std::cbrt(81.0);
+    const double cbrt9 = std::cbrt(9.0);
+    const double lambda = (6.0 + cbrt81 - cbrt9) / 30.0;
+    const double alpha = (12.0 - cbrt81 + cbrt9) / 60.0;
+    const double beta = (cbrt81 + cbrt9) * std::sqrt(3.0) / 60.0;
+    const double u1 = 1.0 / lambda;
+    const std::complex<double> complexEigenvalue = std::complex<double>(alpha, beta) / (alpha * alpha + beta * beta);
+
+    // Матрица собственных векторов T и обратная к ней
+    Eigen::Matrix3d tr;
+    tr << 9.1232394870892942792e-02, -0.14125529502095420843, -3.0029194105147424492e-02,
+        0.24171793270710701896, 0.20412935229379993199, 0.38294211275726193779,
+        0.96604818261509293619, 1.0, 0.0;
+    Eigen::Matrix3d ti;
+    ti << 4.3255798900631553510, 0.33919925181580986954, 0.54177053993587487119,
+        -4.1787185915519047273, -0.32768282076106238708, 0.47662355450055045196,
+        -0.50287263494578687595, 2.5719269498556054292, -0.59603920482822492497;
+
+    const double safety = 0.9;
+    const double minFactor = 0.2;
+    const double maxFactor = 8.0;
+    const double keepStepFactor = 1.2;
+    // Скорость сходимости Ньютона, при которой Якобиан сохраняется на следующий шаг
+    const double jacobianReuseRate = 0.001;
+    const double eps = std::numeric_limits<double>::epsilon();
+    const size_t maxIterations = std::max<size_t>(m_options.maxNewtonIterations, 1);
+    const double iterationFactor = static_cast<double>(maxIterations);
+
+    // Допуски пересчитываются под порядок метода, как в RADAU5
+    const double relTolerance = 0.1 * std::pow(m_options.relTolerance, 2.0 / 3.0);
+    const double absTolerance = relTolerance * (m_options.absTolerance / m_options.relTolerance);
+    const double newtonTolerance = std::max(10.0 * eps / relTolerance, std::min(0.03, std::sqrt(relTolerance)));
+
+    const Eigen::Index n = state.y.size();
+    auto meanSquare = [n](const auto& v, const Vector& scale)
+    {
+        return (v.array() / scale.array()).square().sum() / static_cast<double>(n);
+    };
+
+    SolveResult result;
+    double& t = state.t;
+    Vector& y = state.y;
+    Vector f(n);
+    evaluate(system, t, y, f);
+
+    // Стадии Z, преобразованные стадии W = T^-1 Z и коэффициенты полинома коллокации прошлого шага
+    Vector z1(n), z2(n), z3(n);
+    Vector w1(n), w2(n), w3(n);
+    Vector k1(n), k2(n), k3(n);
+    Vector continuation1 = Vector::Zero(n);
+    Vector continuation2 = Vector::Zero(n);
+    Vector continuation3 = Vector::Zero(n);
+    Vector stage(n);
+    Vector rhs(n);
+    Vector delta(n);
+    Vector errorRhs(n);
+    Vector error(n);
+    Vector scale(n);
+    ComplexVector complexRhs(n);
+    ComplexVector complexDelta(n);
+
+    double& h = state.h;
+    if (h <= 0.0)
+        h = m_options.stepSize > 0.0 ? m_options.stepSize : initialStepSize(y, f, m_options);
+    double hOld = h;
+    double hFactorized = 0.0;
+    double hAccepted = 0.0;
+    double errorAccepted = 1.0;
+    double convergenceFactor = 1.0;
+    bool first = true;
+    bool rejectedLast = false;
+    bool needJacobian = true;
+    bool jacobianCurrent = false;
+
+    std::unique_ptr<LinearSolver> linearSolver = createLinearSolver(system, static_cast<size_t>(n));
+
+    while (t < endTime) {
+        if (belowThreshold(y, m_options.stopThreshold))
+            return { SolveStatus::BelowThreshold, t, result.acceptedSteps, result.rejectedSteps };
+
+        if (result.acceptedSteps + result.rejectedSteps >= m_options.maxSteps)
+            return { SolveStatus::MaxStepsExceeded, t, result.acceptedSteps, result.rejectedSteps };
+
+        if (m_options.maxStepSize > 0.0)
+            h = std::min(h, m_options.maxStepSize);
+
+        const double remaining = endTime - t;
+        if (h >= remaining || remaining - h < m_options.minStepSize)
+            h = remaining;
+
+        if (h < m_options.minStepSize)
+            return { SolveStatus::StepSizeTooSmall, t, result.acceptedSteps, result.rejectedSteps };
+
+        if (needJacobian) {
+            linearSolver->evaluateJacobian(t, y);
+            needJacobian = false;
+            jacobianCurrent = true;
+            hFactorized = 0.0;
+        }
+        if (h != hFactorized) {
+            linearSolver->factorize(h / u1);
+            linearSolver->factorizeComplex(h / complexEigenvalue);
+            hFactorized = h;
+        }
+
+        scale = (absTolerance + relTolerance * y.array().abs()).matrix();
+
+        // Начальное приближение - экстраполяция полинома коллокации прошлого шага
+        if (first) {
+            z1.setZero();
+            z2.setZero();
+            z3.setZero();
+        }
+        else {
+            const double c3q = h / hOld;
+            const double c1q = c1 * c3q;
+            const double c2q = c2 * c3q;
+            z1.noalias() = c1q * (continuation1 + (c1q - c2m1) * (continuation2 + (c1q - c1m1) * continuation3));
+            z2.noalias() = c2q * (continuation1 + (c2q - c2m1) * (continuation2 + (c2q - c1m1) * continuation3));
+            z3.noalias() = c3q * (continuation1 + (c3q - c2m1) * (continuation2 + (c3q - c1m1) * continuation3));
+        }
+        w1.noalias() = ti(0, 0) * z1 + ti(0, 1) * z2 + ti(0, 2) * z3;
+        w2.noalias() = ti(1, 0) * z1 + ti(1, 1) * z2 + ti(1, 2) * z3;
+        w3.noalias() = ti(2, 0) * z1 + ti(2, 1) * z2 + ti(2, 2) * z3;
+
+        // Упрощённый метод Ньютона в переменных W
+        convergenceFactor = std::pow(std::max(convergenceFactor, eps), 0.8);
+        double rate = jacobianReuseRate;
+        double previousNorm = 0.0;
+        double previousQuotient = 0.0;
+        double failureFactor = 0.0;
+        size_t iterations = 0;
+
+        for (;;) {
+            if (iterations >= maxIterations) {
+                failureFactor = 0.5;
+                break;
+            }
+
+            stage.noalias() = y + z1;
+            evaluate(system, t + c1 * h, stage, k1);
+            stage.noalias() = y + z2;
+            evaluate(system, t + c2 * h, stage, k2);
+            stage.noalias() = y + z3;
+            evaluate(system, t + h, stage, k3);
+
+            // (I - h/u1 J) dW1 = h/u1 (T^-1 F)_1 - W1 и то же с комплексным h/(alpha + i beta) для dW2 + i dW3
+            rhs.noalias() = (h / u1) * (ti(0, 0) * k1 + ti(0, 1) * k2 + ti(0, 2) * k3) - w1;
+            linearSolver->solve(rhs, delta);
+
+            const std::complex<double> complexStep = h / complexEigenvalue;
+            for (Eigen::Index i = 0; i < n; ++i) {
+                const std::complex<double> transformed(ti(1, 0) * k1[i] + ti(1, 1) * k2[i] + ti(1, 2) * k3[i],
+                                                       ti(2, 0) * k1[i] + ti(2, 1) * k2[i] + ti(2, 2) * k3[i]);
+                complexRhs[i] = complexStep * transformed - std::complex<double>(w2[i], w3[i]);
+            }
+            linearSolver->solveComplex(complexRhs, complexDelta);
+            ++iterations;
+            count(m_statistics.newtonIterations);
+
+            const double norm = std::sqrt((meanSquare(delta, scale) + meanSquare(complexDelta.real(), scale)
+                                           + meanSquare(complexDelta.imag(), scale)) / 3.0);
+            if (!std::isfinite(norm)) {
+                failureFactor = 0.5;
+                break;
+            }
+
+            if (iterations > 1 && iterations < maxIterations) {
+                const double quotient = norm / previousNorm;
+                rate = iterations == 2 ? quotient : std::sqrt(quotient * previousQuotient);
+                previousQuotient = quotient;
+
+                if (rate >= 0.99) {
+                    failureFactor = 0.5;
+                    break;
+                }
+
+                // Если оставшихся итераций заведомо не хватит, шаг уменьшается сразу
+                convergenceFactor = rate / (1.0 - rate);
+                const double remainingIterations = static_cast<double>(maxIterations - 1 - iterations);
+                const double predicted = convergenceFactor * norm * std::pow(rate, remainingIterations)
+                                         / newtonTolerance;
+                if (predicted >= 1.0) {
+                    const double quotientNewton = std::clamp(predicted, 1e-4, 20.0);
+                    failureFactor = 0.8 * std::pow(quotientNewton, -1.0 / (4.0 + remainingIterations));
+                    break;
+                }
+            }
+            previousNorm = std::max(norm, eps);
+
+            w1 += delta;
+            w2 += complexDelta.real();
+            w3 += complexDelta.imag();
+            z1.noalias() = tr(0, 0) * w1 + tr(0, 1) * w2 + tr(0, 2) * w3;
+            z2.noalias() = tr(1, 0) * w1 + tr(1, 1) * w2 + tr(1, 2) * w3;
+            z3.noalias() = tr(2, 0) * w1 + w2;
+
+            if (convergenceFactor * norm <= newtonTolerance)
+                break;
+        }
+
+        if (failureFactor > 0.0) {
+            // Сначала обновляется Якобиан, затем только уменьшается шаг
+            ++result.rejectedSteps;
+            rejectedLast = true;
+            h *= failureFactor;
+            needJacobian = !jacobianCurrent;
+            continue;
+        }
+
+        // Оценка погрешности встроенной формулой третьего порядка, сглаженная (I - h/u1 J)^-1
+        errorRhs.noalias() = (dd1 / h) * z1 + (dd2 / h) * z2 + (dd3 / h) * z3;
+        rhs.noalias() = (h / u1) * (f + errorRhs);
+        linearSolver->solve(rhs, error);
+        double norm = std::max(std::sqrt(meanSquare(error, scale)), 1e-10);
+
+        // На первом шаге и после отказа оценка может быть завышена на жёстких компонентах
+        if (norm >= 1.0 && (first || rejectedLast)) {
+            stage.noalias() = y + error;
+            evaluate(system, t, stage, k1);
+            rhs.noalias() = (h / u1) * (k1 + errorRhs);
+            linearSolver->solve(rhs, error);
+            norm = std::max(std::sqrt(meanSquare(error, scale)), 1e-10);
+        }
+
+        const double iterationSafety = std::min(safety, safety * (1.0 + 2.0 * iterationFactor)
+                                                            / (static_cast<double>(iterations) + 2.0 * iterationFactor));
+        double quotient = std::clamp(std::pow(norm, 0.25) / iterationSafety, 1.0 / maxFactor, 1.0 / minFactor);
+        double hNew = h / quotient;
+
+        if (norm >= 1.0) {
+            ++result.rejectedSteps;
+            rejectedLast = true;
+            h = first ? 0.1 * h : hNew;
+            needJacobian = !jacobianCurrent;
+            continue;
+        }
+
+        // Предсказывающий регулятор Густафссона
+        if (result.acceptedSteps > 0) {
+            const double predictive = (hAccepted / h) * std::pow(norm * norm / errorAccepted, 0.25) / safety;
+            quotient = std::max(quotient, std::clamp(predictive, 1.0 / maxFactor, 1.0 / minFactor));
+            hNew = h / quotient;
+        }
+        hAccepted = h;
+        errorAccepted = std::max(1e-2, norm);
+
+        t = (h == remaining) ? endTime : t + h;
+        y += z3;
+        ++result.acceptedSteps;
+        first = false;
+
+        // Коэффициенты полинома коллокации для начального приближения следующего шага
+        continuation1.noalias() = (z2 - z3) / c2m1;
+        k1.noalias() = (z1 - z2) / c1mc2;
+        k2.noalias() = (k1 - z1 / c1) / c2;
+        continuation2.noalias() = (k1 - continuation1) / c1m1;
+        continuation3.noalias() = continuation2 - k2;
+        hOld = h;
+
+        evaluate(system, t, y, f);
+        const bool terminal = terminalEvent(t, y);
+        output(trajectory, t, y);
+        if (terminal)
+            return { SolveStatus::TerminalEvent, t, result.acceptedSteps, result.rejectedSteps };
+        if (m_progress && !m_progress(t))
+            return { SolveStatus::Cancelled, t, result.acceptedSteps, result.rejectedSteps };
+        notifyCheckpoint(state, result.acceptedSteps);
+
+        if (rejectedLast)
+            hNew = std::min(hNew, h);
+        rejectedLast = false;
+        jacobianCurrent = false;
+
+        // При быстрой сходимости Якобиан сохраняется, а при почти прежнем шаге - и разложения
+        const double factor = hNew / h;
+        if (rate <= jacobianReuseRate && factor >= 1.0 && factor < keepStepFactor)
+            continue;
+
+        h = hNew;
+        needJacobian = rate > jacobianReuseRate;
+    }
+
+    return { SolveStatus::Finished, t, result.acceptedSteps, result.rejectedSteps };
+}
+
+// Экспоненциальный метод Розенброка exprb32 (Hochbruck, Ostermann, Schweitzer, 2009):
+// y_{n+1} = U + 2h phi_3(hJ) D, U = y_n + h phi_1(hJ) f_n + h^2 phi_2(hJ) v, D = g(t_n + h, U) - g(t_n, y_n),
+// g(t, u) = f(t, u) - J u - v t. Для неавтономных систем v = df/dt(t_n, y_n) считается разностью по t;
+// у автономных разность точно равна нулю, и слагаемое с phi_2 пропускается.
+// Линейная часть J = J(y_n) интегрируется точно, поэтому шаг ограничен только точностью, а линейная система
+// решается без погрешности метода. Вложенный метод Розенброка - Эйлера (U) даёт оценку погрешности 2h phi_3(hJ) D.
+// До denseExponentialLimit матрицы phi_k(hJ) считаются Паде и переиспользуются, пока не меняются J и h;
+// для больших систем произведения phi_k(hJ) v строятся по Крылову.
+SolveResult StiffOdeSolver::solveExponentialRosenbrock(const InPlaceSystem& system, SolverCheckpoint& state,
+                                                       double endTime, Trajectory& trajectory) const
+{
+    const double safety = 0.9;
+    const double minFactor = 0.2;
+    const double maxFactor = 5.0;
+    const double keepStepFactor = 1.2;
+    // Доля допуска шага, отводимая на погрешность крыловских аппроксимаций
+    const double krylovTolerance = 0.1;
+
+    const Eigen::Index n = state.y.size();
+    const bool dense = static_cast<size_t>(n) <= m_options.denseExponentialLimit;
+
+    SolveResult result;
+    double& t = state.t;
+    Vector& y = state.y;
+    Vector f(n);
+    evaluate(system, t, y, f);
+
+    std::unique_ptr<LinearSolver> linearSolver = createLinearSolver(system, static_cast<size_t>(n));
+    const LinearOperator jacobianProduct = [&linearSolver](const Vector& v, Vector& product)
+    {
+        linearSolver->multiply(v, product);
+    };
+
+    // Плотные phi-матрицы и Якобиан, для которого они вычислены
+    Matrix jacobian;
+    Matrix phiJacobian;
+    std::vector<Matrix> phi;
+    double phiStepSize = 0.0;
+    KrylovPhi krylov(dense ? 0 : n, static_cast<Eigen::Index>(std::max<size_t>(m_options.maxKrylovDimension, 1)));
+    Matrix krylovProducts(n, 3);
+
+    // Рабочие векторы шага
+    Vector step(n);
+    Vector stage(n);
+    Vector stageF(n);
+    Vector product(n);
+    Vector remainder(n);
+    Vector correction(n);
+    Vector yNew(n);
+    Vector scale(n);
+    Vector krylovScale(n);
+    Vector timeDerivative(n);
+    bool autonomous = true;
+
+    double& h = state.h;
+    if (h <= 0.0)
+        h = m_options.stepSize > 0.0 ? m_options.stepSize : initialStepSize(y, f, m_options);
+    bool rejectedLast = false;
+    bool jacobianCurrent = false;
+
+    while (t < endTime) {
+        if (belowThreshold(y, m_options.stopThreshold))
+            return { SolveStatus::BelowThreshold, t, result.acceptedSteps, result.rejectedSteps };
+
+        if (result.acceptedSteps + result.rejectedSteps >= m_options.maxSteps)
+            return { SolveStatus::MaxStepsExceeded, t, result.acceptedSteps, result.rejectedSteps };
+
+        if (m_options.maxStepSize > 0.0)
+            h = std::min(h, m_options.maxStepSize);
+
+        const double remaining = endTime - t;
+        if (h >= remaining || remaining - h < m_options.minStepSize)
+            h = remaining;
+
+        if (h < m_options.minStepSize)
+            return { SolveStatus::StepSizeTooSmall, t, result.acceptedSteps, result.rejectedSteps };
+
+        if (!jacobianCurrent) {
+            linearSolver->evaluateJacobian(t, y);
+            if (dense)
+                linearSolver->denseJacobian(jacobian);
+
+            // df/dt правой разностью; product служит временным буфером
+            const double delta = std::sqrt(std::numeric_limits<double>::epsilon()) * std::max(std::abs(t), h);
+            evaluate(system, t + delta, y, product);
+            timeDerivative.noalias() = (product - f) / delta;
+            autonomous = timeDerivative.isZero(0.0);
+            jacobianCurrent = true;
+        }
+
+        errorScale(y, m_options, scale);
+        bool converged = true;
+
+        // U = y + h phi_1(hJ) f + h^2 phi_2(hJ) v
+        if (dense) {
+            if (phi.empty() || h != phiStepSize || jacobian != phiJacobian) {
+                phi = phiMatrices(jacobian, h, 3);
+                phiJacobian = jacobian;
+                phiStepSize = h;
+            }
+            step.noalias() = h * (phi[1] * f);
+            if (!autonomous)
+                step.noalias() += (h * h) * (phi[2] * timeDerivative);
+        }
+        else {
+            krylovScale = scale / h;
+            converged = krylov.apply(jacobianProduct, h, f, 1, krylovScale, krylovTolerance, krylovProducts);
+            step.noalias() = h * krylovProducts.col(0);
+            if (converged && !autonomous) {
+                krylovScale = scale / (h * h);
+                converged = krylov.apply(jacobianProduct, h, timeDerivative, 2, krylovScale, krylovTolerance,
+                                         krylovProducts);
+                step.noalias() += (h * h) * krylovProducts.col(1);
+            }
+        }
+
+        // Нелинейный остаток D = f(t + h, U) - f(t, y) - J (U - y) - h v и поправка 2h phi_3(hJ) D
+        if (converged) {
+            stage.noalias() = y + step;
+            evaluate(system, t + h, stage, stageF);
+            linearSolver->multiply(step, product);
+            remainder.noalias() = stageF - f - product;
+            if (!autonomous)
+                remainder.noalias() -= h * timeDerivative;
+
+            if (dense) {
+                correction.noalias() = (2.0 * h) * (phi[3] * remainder);
+            }
+            else {
+                krylovScale = scale / (2.0 * h);
+                converged = krylov.apply(jacobianProduct, h, remainder, 3, krylovScale, krylovTolerance,
+                                         krylovProducts);
+                correction.noalias() = (2.0 * h) * krylovProducts.col(2);
+            }
+        }
+
+        if (!converged) {
+            // Подпространства допустимой размерности не хватило: уменьшаем шаг
+            ++result.rejectedSteps;
+            rejectedLast = true;
+            h *= 0.5;
+            continue;
+        }
+
+        yNew.noalias() = stage + correction;
+        const double norm = errorNorm(correction, y, yNew, m_options.relTolerance, m_options.absTolerance);
+
+        double factor = norm > 0.0 ? safety * std::pow(norm, -1.0 / 3.0) : maxFactor;
+        factor = std::clamp(factor, minFactor, rejectedLast ? 1.0 : maxFactor);
+        if (factor >= 1.0 && factor < keepStepFactor)
+            factor = 1.0;
+
+        if (norm <= 1.0) {
+            t = (h == remaining) ? endTime : t + h;
+            y.swap(yNew);
+            evaluate(system, t, y, f);
+            const bool terminal = terminalEvent(t, y);
+            output(trajectory, t, y);
+            ++result.acceptedSteps;
+            rejectedLast = false;
+            jacobianCurrent = false;
+
+            if (terminal)
+                return { SolveStatus::TerminalEvent, t, result.acceptedSteps, result.rejectedSteps };
+            if (m_progress && !m_progress(t))
+                return { SolveStatus::Cancelled, t, result.acceptedSteps, result.rejectedSteps };
+            notifyCheckpoint(state, result.acceptedSteps);
+        }
+        else {
+            ++result.rejectedSteps;
+            rejectedLast = true;
+        }
+
+        h *= factor;
+    }
+
+    return { SolveStatus::Finished, t, result.acceptedSteps, result.rejectedSteps };
+}
+}
@@ -0,0 +1,198 @@
+#pragma once
+
+#include "StiffOdeDenseOutput.hpp"
+#include "StiffOdeEvents.hpp"
+#include "StiffOdeGrid.hpp"
+#include "StiffOdeLinearSolver.hpp"
+#include "StiffOdeSensitivity.hpp"
+#include "StiffOdeStatistics.hpp"
+#include "StiffOdeTrajectory.hpp"
+#include "StiffOdeTypes.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace StiffOde
+{
+enum class Method
+{
+    BackwardEuler, // неявный метод Эйлера с постоянным шагом
+    TrBdf2,        // TR-BDF2 с вложенной оценкой погрешности и выбором шага
+    Bdf,           // формулы дифференцирования назад переменного порядка 1-5 с выбором шага и порядка
+    Radau5,        // трёхстадийный Radau IIA пятого порядка с выбором шага
+    ExponentialRosenbrock, // экспоненциальный метод Розенброка exprb32 третьего порядка с выбором шага
+    Automatic      // как в LSODA: явный Дорманд - Принс 5(4) на нежёстких участках, BDF 1-5 на жёстких
+};
+
+// Смена метода при Method::Automatic: stiff = true - переход на BDF в момент t, false - на явный метод
+using MethodSwitchCallback = std::function<void(double t, bool stiff)>;
+
+struct SolverOptions
+{
+    Method method = Method::BackwardEuler;
+    double stepSize = 0.1;      // постоянный шаг; для адаптивных методов - начальный (0 - выбрать автоматически)
+    double relTolerance = 1e-6;
+    double absTolerance = 1e-9;
+    double minStepSize = 1e-14;
+    double maxStepSize = 0.0;   // 0 - без ограничения
+    size_t maxSteps = 1000000;
+    size_t maxNewtonIterations = 7;
+    // Остановка, когда все компоненты по модулю не больше порога; 0 - не проверять.
+    // Для остановки по условиям на решение предназначены события (StiffOdeSolver::setEvents)
+    double stopThreshold = 0.0;
+    bool storeTrajectory = true; // false - точки передаются только в OutputCallback
+    // Экспоненциальный метод: до этой размерности phi-функции Якобиана считаются плотными матрицами,
+    // для больших систем - произведениями на вектор в подпространстве Крылова не больше maxKrylovDimension
+    size_t denseExponentialLimit = 64;
+    size_t maxKrylovDimension = 30;
+    // Через сколько принятых шагов передавать состояние в CheckpointCallback; 0 - не передавать
+    size_t checkpointInterval = 0;
+};
+
+enum class SolveStatus
+{
+    Finished,
+    BelowThreshold,
+    MaxStepsExceeded,
+    StepSizeTooSmall,
+    NewtonFailure,
+    Cancelled,
+    TerminalEvent,  // stopTime - момент терминального события
+    InvalidOptions  // метод или параметры не поддерживаются решателем; счёт не начинался
+};
+
+struct SolveResult
+{
+    SolveStatus status = SolveStatus::Finished;
+    double stopTime = 0.0;
+    size_t acceptedSteps = 0;
+    size_t rejectedSteps = 0;
+};
+
+// Состояние решателя, достаточное для продолжения счёта с того же места. Якобиан и LU-разложения
+// не сохраняются: они зависят от способа хранения и при продолжении вычисляются заново на первом шаге.
+struct SolverCheckpoint
+{
+    Method method = Method::BackwardEuler;
+    double t = 0.0;
+    Vector y;
+    double h = 0.0;             // следующий шаг; 0 - выбрать заново
+    // BDF: порядок (0 - истории нет), модифицированные разности D_0..D_{order+2} по столбцам
+    // и число шагов постоянной длины с последней смены шага или порядка
+    int order = 0;
+    Matrix history;
+    size_t equalSteps = 0;
+    bool stiff = false;         // Method::Automatic: счёт шёл участком BDF
+    // Чувствительности dy/dp по столбцам (n x p; пусто - не считаются) и их разности BDF
+    // в тех же столбцах истории, что и у y: блок строк i - параметр i
+    Matrix sensitivities;
+    Matrix sensitivityHistory;
+};
+
+// Получает состояние каждые SolverOptions::checkpointInterval принятых шагов, например для записи на диск
+using CheckpointCallback = std::function<void(const SolverCheckpoint& checkpoint)>;
+
+// Численный решатель без зависимостей от Qt: результат пишется в Trajectory.
+class StiffOdeSolver
+{
+public:
+    explicit StiffOdeSolver(const System& system = {});
+
+    void setSystem(const System& system);
+    const System& system() const;
+    // Правая часть, записывающая производные на место; заменяет заданную через setSystem
+    void setInPlaceSystem(const InPlaceSystem& system);
+    const InPlaceSystem& inPlaceSystem() const;
+    // Якобиан правой части; если не задан, вычисляется конечными разностями
+    void setJacobian(const JacobianFunction& jacobian);
+    const JacobianFunction& jacobian() const;
+    void setSparseJacobian(const SparseJacobianFunction& jacobian);
+    // Способ хранения Якобиана и решения линейных систем неявной стадии
+    void setJacobianStructure(const JacobianStructure& structure);
+    const JacobianStructure& jacobianStructure() const;
+    void setProgressCallback(const ProgressCallback& callback);
+    void setOutputCallback(const OutputCallback& callback);
+    void setMethodSwitchCallback(const MethodSwitchCallback& callback);
+    void setCheckpointCallback(const CheckpointCallback& callback);
+    // События, отслеживаемые на каждом принятом шаге; терминальное событие заканчивает решение в своей точке
+    void setEvents(const std::vector<Event>& events);
+    const std::vector<Event>& events() const;
+    // Прямые чувствительности к p параметрам: df/dp и начальные dy0/dp (n x p, обычно нулевые).
+    // Считаются неявным методом Эйлера и BDF (в том числе при продолжении из контрольной точки); шаг и
+    // порядок выбираются по погрешности одного состояния. Пустая функция отключает расчёт
+    void setSensitivities(const ParameterJacobianFunction& parameterJacobian, const Matrix& initialSensitivities);
+    size_t sensitivityParameterCount() const;
+    void setOptions(const SolverOptions& options);
+    const SolverOptions& options() const;
+
+    SolveResult solve(const std::vector<double>& initialConditions, double startTime, double endTime,
+                      Trajectory& trajectory) const;
+    // Продолжение счёта из контрольной точки до endTime. Точки дописываются к trajectory, если она содержит
+    // решение той же размерности, иначе траектория начинается заново с контрольной точки.
+    // История BDF используется, только если контрольная точка получена тем же методом
+    SolveResult resume(const SolverCheckpoint& checkpoint, double endTime, Trajectory& trajectory) const;
+    // Состояние в конце последнего вызова solve() или resume(), в том числе прерванного
+    const SolverCheckpoint& checkpoint() const;
+    // Непрерывное продолжение решения, полученного текущим методом; траектория должна жить дольше результата
+    DenseOutput denseOutput(const TrajectoryData& trajectory) const;
+    // Счётчики последнего вызова solve()
+    const SolverStatistics& statistics() const;
+    // События, произошедшие при последнем вызове solve(), в порядке времени
+    const std::vector<EventOccurrence>& eventOccurrences() const;
+    // Чувствительности в точках, выведенных последним вызовом solve() или resume(): компонента i * n + j -
+    // dy_j/dp_i. Пусто, если они не заданы, метод их не поддерживает или траектория не хранится в памяти
+    const Trajectory& sensitivityTrajectory() const;
+
+private:
+    std::unique_ptr<LinearSolver> createLinearSolver(const InPlaceSystem& system, size_t size) const;
+    void output(Trajectory& trajectory, double t, const Vector& y) const;
+    // Поиск событий на только что принятом шаге, до его вывода; при терминальном событии
+    // t и y переносятся в точку события и возвращается true
+    bool terminalEvent(double& t, Vector& y) const;
+    bool sensitivitiesSupported() const;
+    void outputSensitivities(double t, const Matrix& sensitivities) const;
+    void notifyCheckpoint(const SolverCheckpoint& state, size_t acceptedSteps) const;
+    // Общая часть solve() и resume(): счёт методом m_options.method из state, который остаётся конечным состоянием
+    SolveResult integrate(SolverCheckpoint& state, double endTime, Trajectory& trajectory) const;
+
+    SolveResult solveBackwardEuler(const InPlaceSystem& system, SolverCheckpoint& state, double endTime,
+                                   Trajectory& trajectory) const;
+    SolveResult solveTrBdf2(const InPlaceSystem& system, SolverCheckpoint& state, double endTime,
+                            Trajectory& trajectory) const;
+    SolveResult solveBdf(const InPlaceSystem& system, SolverCheckpoint& state, double endTime,
+                         Trajectory& trajectory) const;
+    SolveResult solveAutomatic(const InPlaceSystem& system, SolverCheckpoint& state, double endTime,
+                               Trajectory& trajectory) const;
+    // Участки интегрирования от state до endTime. true - участок завершён со статусом в result,
+    // false - обнаружена смена жёсткости (только при detectSwitch) и счёт нужно продолжить другим методом
+    bool advanceBdf(const InPlaceSystem& system, double endTime, Trajectory& trajectory, SolverCheckpoint& state,
+                    SolveResult& result, bool detectSwitch) const;
+    bool advanceDormandPrince(const InPlaceSystem& system, double endTime, Trajectory& trajectory,
+                              SolverCheckpoint& state, SolveResult& result, bool detectSwitch) const;
+    SolveResult solveRadau5(const InPlaceSystem& system, SolverCheckpoint& state, double endTime,
+                            Trajectory& trajectory) const;
+    SolveResult solveExponentialRosenbrock(const InPlaceSystem& system, SolverCheckpoint& state, double endTime,
+                                           Trajectory& trajectory) const;
+
+    System m_system;
+    InPlaceSystem m_inPlaceSystem;
+    JacobianFunction m_jacobian;
+    SparseJacobianFunction m_sparseJacobian;
+    JacobianStructure m_jacobianStructure;
+    ProgressCallback m_progress;
+    OutputCallback m_output;
+    MethodSwitchCallback m_methodSwitch;
+    CheckpointCallback m_checkpointCallback;
+    std::vector<Event> m_events;
+    ParameterJacobianFunction m_parameterJacobian;
+    Matrix m_initialSensitivities;
+    SolverOptions m_options;
+    mutable SolverStatistics m_statistics;
+    mutable std::optional<EventLocator> m_eventLocator;
+    mutable std::vector<EventOccurrence> m_eventOccurrences;
+    mutable SolverCheckpoint m_checkpoint;
+    mutable Trajectory m_sensitivityTrajectory;
+};
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace StiffOde
+{
+// Счётчики и таймеры стоят одного сложения на событие; при сборке с STIFF_ODE_NO_STATISTICS
+// они не собираются вовсе, а поля статистики остаются нулевыми.
+#ifdef STIFF_ODE_NO_STATISTICS
+constexpr bool statisticsEnabled = false;
+#else
+constexpr bool statisticsEnabled = true;
+#endif
+
+// Счётчики одного вызова StiffOdeSolver::solve()
+struct SolverStatistics
+{
+    size_t rhsEvaluations = 0;      // включая вычисления для конечно-разностного Якобиана
+    size_t jacobianEvaluations = 0;
+    size_t factorizations = 0;      // вещественные и комплексные LU-разложения
+    size_t linearSolves = 0;
+    size_t newtonIterations = 0;
+    size_t acceptedSteps = 0;
+    size_t rejectedSteps = 0;
+    size_t methodSwitches = 0;      // переходы между явным и неявным методом при Method::Automatic
+};
+
+// Длительность этапов расчёта в секундах
+struct PhaseTimings
+{
+    double solveSeconds = 0.0;
+    double globalErrorSeconds = 0.0;
+    double chartDataSeconds = 0.0;  // прореживание серий графиков вне GUI-потока, вместе с расчётом точного решения
+    double uiSeconds = 0.0;         // построение графиков и таблиц в GUI-потоке
+};
+
+struct RunStatistics
+{
+    SolverStatistics solver;
+    PhaseTimings phases;
+};
+
+inline void count(size_t& counter, size_t increment = 1)
+{
+#ifndef STIFF_ODE_NO_STATISTICS
+    counter += increment;
+#else
+    (void)counter;
+    (void)increment;
+#endif
+}
+
+// Добавляет к seconds время жизни объекта
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(double& seconds)
+#ifndef STIFF_ODE_NO_STATISTICS
+        : m_seconds(seconds), m_start(std::chrono::steady_clock::now())
+#endif
+    {
+        (void)seconds;
+    }
+
+    ~ScopedTimer()
+    {
+#ifndef STIFF_ODE_NO_STATISTICS
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_start;
+        m_seconds += elapsed.count();
+#endif
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+#ifndef STIFF_ODE_NO_STATISTICS
+    double& m_seconds;
+    std::chrono::steady_clock::time_point m_start;
+#endif
+};
+}
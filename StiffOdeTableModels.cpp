@@ -0,0 +1,169 @@
+#include "StiffOdeTableModels.hpp"
+#include "StiffOdeModel.hpp"
+
+#include <QString>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace StiffOde
+{
+namespace
+{
+// Число строк ограничено диапазоном int, которым оперирует QAbstractItemModel
+int clampedRowCount(size_t size)
+{
+    return static_cast<int>(std::min<size_t>(size, static_cast<size_t>(std::numeric_limits<int>::max())));
+}
+}
+
+TrajectoryTableModel::TrajectoryTableModel(const StiffOdeModel& model, QObject* parent)
+    : QAbstractTableModel(parent),
+    m_model(model),
+    m_trajectory(model.getTrajectoryData()),
+    m_exactRow(m_trajectory.numComponents()),
+    m_exactRowIndex(0)
+{
+}
+
+const double* TrajectoryTableModel::exactRow(size_t row) const
+{
+    if (m_exactRowIndex != row || !m_exactRowValid) {
+        m_exactRowIndex = row;
+        m_exactRowValid = m_model.exactSolutionAt(m_trajectory.time(row), m_exactRow.data());
+    }
+    return m_exactRowValid ? m_exactRow.data() : nullptr;
+}
+
+int TrajectoryTableModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : clampedRowCount(m_trajectory.size());
+}
+
+int TrajectoryTableModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : 2 + static_cast<int>(m_trajectory.numComponents()) * 3;
+}
+
+QVariant TrajectoryTableModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || role != Qt::DisplayRole)
+        return QVariant();
+
+    const size_t row = static_cast<size_t>(index.row());
+    const int column = index.column();
+    const int numVariables = static_cast<int>(m_trajectory.numComponents());
+
+    if (column == 0)
+        return QString::number(row);
+    if (column == 1)
+        return QString::number(m_trajectory.time(row), 'g', 16);
+
+    const int group = (column - 2) / numVariables;
+    const size_t component = static_cast<size_t>((column - 2) % numVariables);
+
+    if (group == 1)
+        return QString::number(m_trajectory.value(component, row), 'g', 16);
+
+    const double* exact = exactRow(row);
+    if (exact == nullptr)
+        return QVariant();
+
+    if (group == 0)
+        return QString::number(exact[component], 'g', 16);
+    return QString::number(m_trajectory.value(component, row) - exact[component], 'g', 16);
+}
+
+QVariant TrajectoryTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QAbstractTableModel::headerData(section, orientation, role);
+
+    if (section == 0)
+        return QString("n");
+    if (section == 1)
+        return QString("x_n");
+
+    const int numVariables = static_cast<int>(m_trajectory.numComponents());
+    const int component = (section - 2) % numVariables;
+    switch ((section - 2) / numVariables) {
+    case 0:
+        return QString("u(%1) (точное)").arg(component + 1);
+    case 1:
+        return QString("u(%1) (численное)").arg(component + 1);
+    default:
+        return QString("E (погрешность)");
+    }
+}
+
+ExactValuesTableModel::ExactValuesTableModel(const StiffOdeModel& model, QObject* parent)
+    : QAbstractTableModel(parent),
+    m_model(model),
+    m_rowCount(model.exactGridSize()),
+    m_exactRow(model.numComponents()),
+    m_exactRowIndex(0)
+{
+}
+
+const double* ExactValuesTableModel::exactRow(size_t row) const
+{
+    if (m_exactRowIndex != row || !m_exactRowValid) {
+        m_exactRowIndex = row;
+        m_exactRowValid = m_model.exactSolutionAt(m_model.exactGridTime(row), m_exactRow.data());
+    }
+    return m_exactRowValid ? m_exactRow.data() : nullptr;
+}
+
+int ExactValuesTableModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : clampedRowCount(m_rowCount);
+}
+
+int ExactValuesTableModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : 4 + static_cast<int>(m_exactRow.size());
+}
+
+QVariant ExactValuesTableModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || role != Qt::DisplayRole)
+        return QVariant();
+
+    const size_t row = static_cast<size_t>(index.row());
+    const double t = m_model.exactGridTime(row);
+
+    switch (index.column()) {
+    case 0:
+        return QString::number(row);
+    case 1:
+        return QString::number(t, 'f', 16);
+    case 2:
+        return QString::number(std::exp(-0.01 * t), 'f', 16);
+    case 3:
+        return QString::number(std::exp(-1000 * t), 'e', 16);
+    }
+
+    const double* exact = exactRow(row);
+    if (exact == nullptr)
+        return QVariant();
+    return QString::number(exact[index.column() - 4], 'f', 16);
+}
+
+QVariant ExactValuesTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QAbstractTableModel::headerData(section, orientation, role);
+
+    switch (section) {
+    case 0:
+        return QString("n");
+    case 1:
+        return QString("x_n");
+    case 2:
+        return QString("exp(-0.01 * x)");
+    case 3:
+        return QString("exp(-1000 * x)");
+    }
+    return QString("u(%1) (точное)").arg(section - 3);
+}
+}
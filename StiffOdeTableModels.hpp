@@ -0,0 +1,63 @@
+#pragma once
+
+#include "StiffOdeTrajectory.hpp"
+
+#include <QAbstractTableModel>
+#include <vector>
+
+namespace StiffOde
+{
+class StiffOdeModel;
+
+// Таблица численного решения: n, x_n, точные значения, численные значения и погрешность по компонентам.
+// Ячейки форматируются при запросе прямо из массивов траектории, точное решение считается в самих узлах x_n;
+// модель расчёта должна жить дольше таблицы.
+class TrajectoryTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit TrajectoryTableModel(const StiffOdeModel& model, QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    // Точное решение в узле строки; строка кэшируется, так как таблица запрашивает её ячейки подряд
+    const double* exactRow(size_t row) const;
+
+    const StiffOdeModel& m_model;
+    const TrajectoryData& m_trajectory;
+    mutable std::vector<double> m_exactRow;
+    mutable size_t m_exactRowIndex;
+    mutable bool m_exactRowValid {false};
+};
+
+// Таблица точного решения вместе с экспонентами exp(-0.01 x) и exp(-1000 x) на сетке точного решения.
+// Траектория точного решения не строится: строка считается при запросе в узле x_n = startExact + n*h,
+// так что память не зависит от числа узлов; модель расчёта должна жить дольше таблицы.
+class ExactValuesTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit ExactValuesTableModel(const StiffOdeModel& model, QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    // Точное решение в узле строки, кэшируется как в TrajectoryTableModel
+    const double* exactRow(size_t row) const;
+
+    const StiffOdeModel& m_model;
+    size_t m_rowCount;
+    mutable std::vector<double> m_exactRow;
+    mutable size_t m_exactRowIndex;
+    mutable bool m_exactRowValid {false};
+};
+}
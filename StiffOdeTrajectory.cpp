@@ -0,0 +1,71 @@
+#include "StiffOdeTrajectory.hpp"
+
+namespace StiffOde
+{
+bool TrajectoryData::empty() const
+{
+    return size() == 0;
+}
+
+Trajectory::Trajectory(size_t numComponents)
+    : m_components(numComponents)
+{
+}
+
+void Trajectory::reset(size_t numComponents)
+{
+    m_times.clear();
+    m_components.assign(numComponents, {});
+}
+
+void Trajectory::reserve(size_t numPoints)
+{
+    m_times.reserve(numPoints);
+    for (auto& values : m_components) {
+        values.reserve(numPoints);
+    }
+}
+
+void Trajectory::append(double t, const double* y)
+{
+    m_times.push_back(t);
+    for (size_t j = 0; j < m_components.size(); ++j) {
+        m_components[j].push_back(y[j]);
+    }
+}
+
+void Trajectory::append(double t, const std::vector<double>& y)
+{
+    append(t, y.data());
+}
+
+size_t Trajectory::size() const
+{
+    return m_times.size();
+}
+
+size_t Trajectory::numComponents() const
+{
+    return m_components.size();
+}
+
+double Trajectory::time(size_t i) const
+{
+    return m_times[i];
+}
+
+double Trajectory::value(size_t component, size_t i) const
+{
+    return m_components[component][i];
+}
+
+const std::vector<double>& Trajectory::times() const
+{
+    return m_times;
+}
+
+const std::vector<double>& Trajectory::component(size_t component) const
+{
+    return m_components[component];
+}
+}
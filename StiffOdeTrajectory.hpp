@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace StiffOde
+{
+// Доступ к точкам траектории независимо от того, где она хранится: в памяти или в файле.
+class TrajectoryData
+{
+public:
+    virtual ~TrajectoryData() = default;
+
+    virtual size_t size() const = 0;
+    virtual size_t numComponents() const = 0;
+    virtual double time(size_t i) const = 0;
+    virtual double value(size_t component, size_t i) const = 0;
+
+    bool empty() const;
+};
+
+// Траектория в виде структуры массивов: массив узлов x_n и по массиву на каждую компоненту.
+class Trajectory final : public TrajectoryData
+{
+public:
+    explicit Trajectory(size_t numComponents = 0);
+
+    void reset(size_t numComponents);
+    void reserve(size_t numPoints);
+    void append(double t, const double* y);
+    void append(double t, const std::vector<double>& y);
+
+    size_t size() const override;
+    size_t numComponents() const override;
+
+    double time(size_t i) const override;
+    double value(size_t component, size_t i) const override;
+    const std::vector<double>& times() const;
+    const std::vector<double>& component(size_t component) const;
+
+private:
+    std::vector<double> m_times;
+    std::vector<std::vector<double>> m_components;
+};
+}
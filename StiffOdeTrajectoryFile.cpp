@@ -0,0 +1,382 @@
+#include "StiffOdeTrajectoryFile.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace StiffOde
+{
+namespace
+{
+const char fileMagic[4] = { 'S', 'O', 'D', 'E' };
+const uint32_t fileVersion = 1;
+// Размер заголовка кратен 8, чтобы записи в отображённом файле были выровнены для double
+const size_t headerSize = 64;
+
+void encodeHeader(const TrajectoryFileHeader& header, unsigned char* bytes)
+{
+    const int32_t method = static_cast<int32_t>(header.method);
+
+    std::memset(bytes, 0, headerSize);
+    std::memcpy(bytes, fileMagic, 4);
+    std::memcpy(bytes + 4, &fileVersion, 4);
+    std::memcpy(bytes + 8, &header.numComponents, 4);
+    std::memcpy(bytes + 12, &method, 4);
+    std::memcpy(bytes + 16, &header.startTime, 8);
+    std::memcpy(bytes + 24, &header.stepSize, 8);
+    std::memcpy(bytes + 32, &header.relTolerance, 8);
+    std::memcpy(bytes + 40, &header.absTolerance, 8);
+    std::memcpy(bytes + 48, &header.numRecords, 8);
+}
+
+bool decodeHeader(const unsigned char* bytes, TrajectoryFileHeader& header)
+{
+    uint32_t version = 0;
+    int32_t method = 0;
+
+    std::memcpy(&version, bytes + 4, 4);
+    if (std::memcmp(bytes, fileMagic, 4) != 0 || version != fileVersion)
+        return false;
+
+    std::memcpy(&header.numComponents, bytes + 8, 4);
+    std::memcpy(&method, bytes + 12, 4);
+    std::memcpy(&header.startTime, bytes + 16, 8);
+    std::memcpy(&header.stepSize, bytes + 24, 8);
+    std::memcpy(&header.relTolerance, bytes + 32, 8);
+    std::memcpy(&header.absTolerance, bytes + 40, 8);
+    std::memcpy(&header.numRecords, bytes + 48, 8);
+    header.method = static_cast<Method>(method);
+    return header.numComponents > 0;
+}
+}
+
+TrajectoryWriter::TrajectoryWriter(size_t batchSize)
+    : m_batchSize(batchSize > 0 ? batchSize : 1)
+{
+}
+
+TrajectoryWriter::~TrajectoryWriter()
+{
+    close();
+}
+
+bool TrajectoryWriter::open(const std::string& path, const TrajectoryFileHeader& header)
+{
+    close();
+
+    m_file = std::fopen(path.c_str(), "wb");
+    if (m_file == nullptr)
+        return false;
+
+    m_header = header;
+    m_header.numRecords = 0;
+    m_failed = false;
+    m_buffer.clear();
+    m_buffer.reserve(m_batchSize * (m_header.numComponents + 1));
+
+    unsigned char bytes[headerSize];
+    encodeHeader(m_header, bytes);
+    m_failed = std::fwrite(bytes, 1, headerSize, m_file) != headerSize;
+    return !m_failed;
+}
+
+bool TrajectoryWriter::append(double t, const double* y)
+{
+    if (m_file == nullptr || m_failed)
+        return false;
+
+    m_buffer.push_back(t);
+    m_buffer.insert(m_buffer.end(), y, y + m_header.numComponents);
+    ++m_header.numRecords;
+
+    if (m_buffer.size() >= m_batchSize * (m_header.numComponents + 1))
+        return flush();
+    return true;
+}
+
+bool TrajectoryWriter::close()
+{
+    if (m_file == nullptr)
+        return false;
+
+    flush();
+
+    unsigned char bytes[headerSize];
+    encodeHeader(m_header, bytes);
+    if (std::fseek(m_file, 0, SEEK_SET) != 0 || std::fwrite(bytes, 1, headerSize, m_file) != headerSize)
+        m_failed = true;
+
+    if (std::fclose(m_file) != 0)
+        m_failed = true;
+    m_file = nullptr;
+    return !m_failed;
+}
+
+bool TrajectoryWriter::isOpen() const
+{
+    return m_file != nullptr;
+}
+
+uint64_t TrajectoryWriter::numRecords() const
+{
+    return m_header.numRecords;
+}
+
+bool TrajectoryWriter::flush()
+{
+    if (!m_buffer.empty() && !m_failed)
+        m_failed = std::fwrite(m_buffer.data(), sizeof(double), m_buffer.size(), m_file) != m_buffer.size();
+    m_buffer.clear();
+    return !m_failed;
+}
+
+TrajectoryReader::~TrajectoryReader()
+{
+    close();
+}
+
+bool TrajectoryReader::open(const std::string& path)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    m_fileHandle = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || static_cast<size_t>(fileSize.QuadPart) < headerSize) {
+        close();
+        return false;
+    }
+    m_mappingSize = static_cast<size_t>(fileSize.QuadPart);
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        close();
+        return false;
+    }
+    m_mappingHandle = mapping;
+
+    m_mapping = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (m_mapping == nullptr) {
+        close();
+        return false;
+    }
+#else
+    const int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat status;
+    if (fstat(file, &status) != 0 || static_cast<size_t>(status.st_size) < headerSize) {
+        ::close(file);
+        return false;
+    }
+    m_mappingSize = static_cast<size_t>(status.st_size);
+
+    // Отображение остаётся действительным и после закрытия дескриптора
+    void* mapping = mmap(nullptr, m_mappingSize, PROT_READ, MAP_SHARED, file, 0);
+    ::close(file);
+    if (mapping == MAP_FAILED) {
+        m_mappingSize = 0;
+        return false;
+    }
+    m_mapping = mapping;
+#endif
+
+    const auto* bytes = static_cast<const unsigned char*>(m_mapping);
+    if (!decodeHeader(bytes, m_header)) {
+        close();
+        return false;
+    }
+
+    // Число записей берётся по размеру файла: так читается и файл, запись которого была прервана
+    m_stride = m_header.numComponents + 1;
+    m_size = (m_mappingSize - headerSize) / (m_stride * sizeof(double));
+    m_records = reinterpret_cast<const double*>(bytes + headerSize);
+    return true;
+}
+
+void TrajectoryReader::close()
+{
+#ifdef _WIN32
+    if (m_mapping != nullptr)
+        UnmapViewOfFile(m_mapping);
+    if (m_mappingHandle != nullptr)
+        CloseHandle(m_mappingHandle);
+    if (m_fileHandle != nullptr)
+        CloseHandle(m_fileHandle);
+    m_mappingHandle = nullptr;
+    m_fileHandle = nullptr;
+#else
+    if (m_mapping != nullptr)
+        munmap(m_mapping, m_mappingSize);
+#endif
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_records = nullptr;
+    m_size = 0;
+    m_stride = 0;
+    m_header = TrajectoryFileHeader();
+}
+
+bool TrajectoryReader::isOpen() const
+{
+    return m_records != nullptr;
+}
+
+const TrajectoryFileHeader& TrajectoryReader::header() const
+{
+    return m_header;
+}
+
+size_t TrajectoryReader::size() const
+{
+    return m_size;
+}
+
+size_t TrajectoryReader::numComponents() const
+{
+    return m_header.numComponents;
+}
+
+double TrajectoryReader::time(size_t i) const
+{
+    return m_records[i * m_stride];
+}
+
+double TrajectoryReader::value(size_t component, size_t i) const
+{
+    return m_records[i * m_stride + 1 + component];
+}
+
+bool saveTrajectory(const TrajectoryData& trajectory, const std::string& path, const TrajectoryFileHeader& header)
+{
+    TrajectoryFileHeader fileHeader = header;
+    fileHeader.numComponents = static_cast<uint32_t>(trajectory.numComponents());
+
+    TrajectoryWriter writer;
+    if (!writer.open(path, fileHeader))
+        return false;
+
+    std::vector<double> y(trajectory.numComponents());
+    for (size_t i = 0; i < trajectory.size(); ++i) {
+        for (size_t j = 0; j < y.size(); ++j)
+            y[j] = trajectory.value(j, i);
+        if (!writer.append(trajectory.time(i), y.data()))
+            break;
+    }
+    return writer.close();
+}
+
+namespace
+{
+std::FILE* openCsv(const std::string& path, size_t numComponents, size_t numParameters = 0)
+{
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr)
+        return nullptr;
+
+    std::fputs("t", file);
+    for (size_t j = 0; j < numComponents; ++j)
+        std::fprintf(file, ",y%zu", j + 1);
+    for (size_t i = 0; i < numParameters; ++i)
+        for (size_t j = 0; j < numComponents; ++j)
+            std::fprintf(file, ",dy%zu/dp%zu", j + 1, i + 1);
+    std::fputc('\n', file);
+    return file;
+}
+
+bool closeCsv(std::FILE* file)
+{
+    const bool failed = std::ferror(file) != 0;
+    return std::fclose(file) == 0 && !failed;
+}
+}
+
+bool exportCsv(const TrajectoryData& trajectory, const std::string& path)
+{
+    const size_t numComponents = trajectory.numComponents();
+    std::FILE* file = openCsv(path, numComponents);
+    if (file == nullptr)
+        return false;
+
+    for (size_t i = 0; i < trajectory.size(); ++i) {
+        std::fprintf(file, "%.17g", trajectory.time(i));
+        for (size_t j = 0; j < numComponents; ++j)
+            std::fprintf(file, ",%.17g", trajectory.value(j, i));
+        std::fputc('\n', file);
+    }
+
+    return closeCsv(file);
+}
+
+bool exportCsv(const TrajectoryData& trajectory, const TrajectoryData& sensitivities, const std::string& path)
+{
+    const size_t numComponents = trajectory.numComponents();
+    const size_t numSensitivities = sensitivities.numComponents();
+    if (numComponents == 0 || numSensitivities % numComponents != 0 || sensitivities.size() != trajectory.size())
+        return false;
+
+    std::FILE* file = openCsv(path, numComponents, numSensitivities / numComponents);
+    if (file == nullptr)
+        return false;
+
+    for (size_t i = 0; i < trajectory.size(); ++i) {
+        std::fprintf(file, "%.17g", trajectory.time(i));
+        for (size_t j = 0; j < numComponents; ++j)
+            std::fprintf(file, ",%.17g", trajectory.value(j, i));
+        for (size_t j = 0; j < numSensitivities; ++j)
+            std::fprintf(file, ",%.17g", sensitivities.value(j, i));
+        std::fputc('\n', file);
+    }
+
+    return closeCsv(file);
+}
+
+bool exportCsv(DenseOutput& solution, size_t numComponents, double step, const std::string& path)
+{
+    if (step <= 0.0)
+        return false;
+
+    std::FILE* file = openCsv(path, numComponents);
+    if (file == nullptr)
+        return false;
+
+    std::vector<double> y(numComponents);
+    const double startTime = solution.startTime();
+    const double endTime = solution.endTime();
+    for (size_t i = 0;; ++i) {
+        // Узел считается от начала, чтобы не накапливать погрешность суммирования шага
+        const double t = std::min(startTime + static_cast<double>(i) * step, endTime);
+        solution.evaluate(t, y.data());
+
+        std::fprintf(file, "%.17g", t);
+        for (size_t j = 0; j < numComponents; ++j)
+            std::fprintf(file, ",%.17g", y[j]);
+        std::fputc('\n', file);
+
+        if (t >= endTime)
+            break;
+    }
+
+    return closeCsv(file);
+}
+}
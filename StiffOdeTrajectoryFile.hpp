@@ -0,0 +1,101 @@
+#pragma once
+
+#include "StiffOdeDenseOutput.hpp"
+#include "StiffOdeSolver.hpp"
+#include "StiffOdeTrajectory.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace StiffOde
+{
+// Двоичный формат траектории: заголовок фиксированного размера, затем записи (t, y_1, ..., y_N) из double
+// в порядке байтов машины. Записи идут подряд, поэтому файл можно дописывать по мере решения
+// и читать через отображение в память без загрузки целиком.
+struct TrajectoryFileHeader
+{
+    uint32_t numComponents = 0;
+    Method method = Method::BackwardEuler;
+    double startTime = 0.0;
+    double stepSize = 0.0;
+    double relTolerance = 0.0;
+    double absTolerance = 0.0;
+    uint64_t numRecords = 0;    // записывается при закрытии файла
+};
+
+// Потоковая запись траектории пакетами по batchSize записей.
+class TrajectoryWriter
+{
+public:
+    explicit TrajectoryWriter(size_t batchSize = 4096);
+    ~TrajectoryWriter();
+
+    TrajectoryWriter(const TrajectoryWriter&) = delete;
+    TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+    bool open(const std::string& path, const TrajectoryFileHeader& header);
+    bool append(double t, const double* y);
+    // Дописывает буфер и число записей в заголовок
+    bool close();
+
+    bool isOpen() const;
+    uint64_t numRecords() const;
+
+private:
+    bool flush();
+
+    std::FILE* m_file {nullptr};
+    TrajectoryFileHeader m_header;
+    std::vector<double> m_buffer;
+    size_t m_batchSize;
+    bool m_failed {false};
+};
+
+// Чтение файла траектории через отображение в память: страницы подгружаются системой по мере обращения,
+// поэтому графики и таблицы могут работать с траекториями больше объёма памяти.
+class TrajectoryReader final : public TrajectoryData
+{
+public:
+    TrajectoryReader() = default;
+    ~TrajectoryReader() override;
+
+    TrajectoryReader(const TrajectoryReader&) = delete;
+    TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const;
+    const TrajectoryFileHeader& header() const;
+
+    size_t size() const override;
+    size_t numComponents() const override;
+    double time(size_t i) const override;
+    double value(size_t component, size_t i) const override;
+
+private:
+    TrajectoryFileHeader m_header;
+    const double* m_records {nullptr};
+    size_t m_size {0};
+    size_t m_stride {0};
+
+    void* m_mapping {nullptr};
+    size_t m_mappingSize {0};
+#ifdef _WIN32
+    void* m_fileHandle {nullptr};
+    void* m_mappingHandle {nullptr};
+#endif
+};
+
+// Запись траектории целиком в двоичный файл
+bool saveTrajectory(const TrajectoryData& trajectory, const std::string& path, const TrajectoryFileHeader& header);
+// Текстовый экспорт: строка заголовков "t,y1,...,yN", затем по строке на точку
+bool exportCsv(const TrajectoryData& trajectory, const std::string& path);
+// С чувствительностями в тех же узлах: после y - столбцы "dyJ/dpI", сначала все компоненты параметра 1
+bool exportCsv(const TrajectoryData& trajectory, const TrajectoryData& sensitivities, const std::string& path);
+// То же на равномерной сетке с шагом step по непрерывному продолжению решения
+bool exportCsv(DenseOutput& solution, size_t numComponents, double step, const std::string& path);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+namespace StiffOde
+{
+using Vector = Eigen::VectorXd;
+using Matrix = Eigen::MatrixXd;
+using SparseMatrix = Eigen::SparseMatrix<double>;
+using ComplexVector = Eigen::VectorXcd;
+using ComplexMatrix = Eigen::MatrixXcd;
+
+using System = std::function<std::vector<double>(const std::vector<double>&, double)>;
+// Правая часть без выделения памяти: f(t, y, dydt) записывает производные в dydt
+using InPlaceSystem = std::function<void(double, const double*, double*)>;
+using JacobianFunction = std::function<Matrix(const std::vector<double>&, double)>;
+using SparseJacobianFunction = std::function<SparseMatrix(const std::vector<double>&, double)>;
+// Вызывается после каждого принятого шага с текущим t; false прерывает решение
+using ProgressCallback = std::function<bool(double)>;
+// Получает каждую точку решения (t, y) по мере её вычисления, например для записи в файл
+using OutputCallback = std::function<void(double, const double*)>;
+}
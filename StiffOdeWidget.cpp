@@ -1,23 +1,90 @@
 #include "StiffOdeModel.hpp"
 #include "StiffOdeWidget.hpp"
+#include "StiffOdeChartDecimator.hpp"
+#include "StiffOdeTableModels.hpp"
 
 #include <QDebug>
 #include <QTabWidget>
 #include <QHeaderView>
+#include <QHBoxLayout>
 #include <QVBoxLayout>
-#include <QTableWidget>
+#include <QTableView>
 #include <QtCharts/QChart>
 #include <QtCharts/QChartView>
 #include <QtCharts/QValueAxis>
 #include <QtCharts/QLineSeries>
+#include <QVector>
+#include <QPointF>
 #include <cmath>
 
 namespace StiffOde
 {
-StiffOdeWidget::StiffOdeWidget(StiffOdeModel* model, QWidget* parent)
+namespace
+{
+// Доступ к точкам компоненты траектории для прореживания графика
+PointFunction componentPointAt(const TrajectoryData& trajectory, size_t component)
+{
+    const TrajectoryData* data = &trajectory;
+    return [data, component](size_t i) { return QPointF(data->time(i), data->value(component, i)); };
+}
+
+// Точки компоненты точного решения на его сетке; значения считаются при прореживании и не хранятся
+PointFunction exactPointAt(const StiffOdeModel& model, size_t component)
+{
+    const StiffOdeModel* data = &model;
+    return [data, component](size_t i)
+    {
+        const double t = data->exactGridTime(i);
+        return QPointF(t, data->exactComponentAt(t, component));
+    };
+}
+
+// Доступ к точкам глобальной погрешности компоненты для прореживания графика
+PointFunction errorPointAt(const GlobalError& errors, Eigen::Index component)
+{
+    const GlobalError* data = &errors;
+    return [data, component](size_t i)
+    {
+        return QPointF(data->times[i], data->errors(static_cast<Eigen::Index>(i), component));
+    };
+}
+
+// Сводка по погрешности первых двух компонент; экстремумы и среднеквадратичная погрешность
+// получены ядром погрешности за тот же проход, что и сама погрешность
+QString errorSummaryText(const GlobalError& globalErrors, const SolveResult& solveResult)
+{
+    if (globalErrors.empty())
+        return QString();
+    if (globalErrors.errors.cols() < 2)
+        return "Недостаточно компонент для построения графиков глобальной погрешности.";
+
+    const ErrorStatistics& statisticsY0 = globalErrors.statistics[0];
+    const ErrorStatistics& statisticsY1 = globalErrors.statistics[1];
+
+    QString summaryText;
+
+    summaryText += QString("Первая компонента:\n");
+    summaryText += QString("  Максимальная погрешность: %1 в точке х =  %2\n").arg(statisticsY0.max).arg(statisticsY0.maxTime);
+    summaryText += QString("  Минимальная погрешность: %1 в точке х =  %2\n").arg(statisticsY0.min).arg(statisticsY0.minTime);
+    summaryText += QString("  Среднеквадратичная погрешность: %1\n").arg(statisticsY0.rms);
+
+    summaryText += QString("\nВторая компонента:\n");
+    summaryText += QString("  Максимальная погрешность: %1 в точке х =  %2\n").arg(statisticsY1.max).arg(statisticsY1.maxTime);
+    summaryText += QString("  Минимальная погрешность: %1 в точке х =  %2\n").arg(statisticsY1.min).arg(statisticsY1.minTime);
+    summaryText += QString("  Среднеквадратичная погрешность: %1\n").arg(statisticsY1.rms);
+    summaryText += QString("\nКоличество шагов: %1 \n").arg(globalErrors.times.size());
+
+    summaryText += QString("Принятых шагов: %1, отклонённых шагов: %2\n")
+                       .arg(solveResult.acceptedSteps).arg(solveResult.rejectedSteps);
+
+    return summaryText;
+}
+}
+
+StiffOdeWidget::StiffOdeWidget(StiffOdeModel* model, const StiffOdeWidgetData& data, QWidget* parent)
     : QWidget(parent),
     m_model(model),
-    m_tableWidget(new QTableWidget(this)),
+    m_tableView(new QTableView(this)),
     m_chartView(new QChartView(this)),
     m_chart(new QChart),
     m_exactChart(new QChart),
@@ -25,11 +92,50 @@ StiffOdeWidget::StiffOdeWidget(StiffOdeModel* model, QWidget* parent)
 {
     setupUi();
 
-    populateTableAndChart();
-    populateExactChart();
-    populateGlobalErrorChart();
-    populateSolutionComparisonChart();
-    populateExactValuesTable();
+    double uiSeconds = 0.0;
+    {
+        ScopedTimer timer(uiSeconds);
+        populateTableAndChart(data);
+        populateExactChart(data);
+        populateGlobalErrorChart(data);
+        populateSolutionComparisonChart(data);
+        populateExactValuesTable();
+    }
+    m_model->setUiTime(uiSeconds);
+    populateStatistics();
+}
+
+StiffOdeWidgetData StiffOdeWidget::prepare(StiffOdeModel& model)
+{
+    double seconds = 0.0;
+    StiffOdeWidgetData data;
+    {
+        ScopedTimer timer(seconds);
+        const TrajectoryData& trajectory = model.getTrajectoryData();
+        const size_t exactCount = model.exactGridSize();
+        const GlobalError& globalErrors = model.computeGlobalError();
+
+        const int solutionSeries = static_cast<int>(trajectory.numComponents());
+        const int exactSeries = exactCount > 0 ? static_cast<int>(model.numComponents()) : 0;
+        const int errorSeries = static_cast<int>(globalErrors.errors.cols());
+
+        std::vector<DecimationTask> tasks;
+        tasks.reserve(static_cast<size_t>(solutionSeries + exactSeries + errorSeries));
+        for (int j = 0; j < solutionSeries; ++j)
+            tasks.push_back({ trajectory.size(), componentPointAt(trajectory, static_cast<size_t>(j)) });
+        for (int j = 0; j < exactSeries; ++j)
+            tasks.push_back({ exactCount, exactPointAt(model, static_cast<size_t>(j)) });
+        for (int j = 0; j < errorSeries; ++j)
+            tasks.push_back({ globalErrors.times.size(), errorPointAt(globalErrors, j) });
+
+        const QVector<QVector<QPointF>> points = decimateAll(tasks);
+        data.solution = points.mid(0, solutionSeries);
+        data.exact = points.mid(solutionSeries, exactSeries);
+        data.globalError = points.mid(solutionSeries + exactSeries, errorSeries);
+        data.errorSummary = errorSummaryText(globalErrors, model.getSolveResult());
+    }
+    model.setChartDataTime(seconds);
+    return data;
 }
 
 void StiffOdeWidget::setupUi()
@@ -39,6 +145,7 @@ void StiffOdeWidget::setupUi()
     QTabWidget* tabWidget = new QTabWidget(this);
 
     m_chartView->setChart(m_chart);
+    m_chartView->setRubberBand(QChartView::RectangleRubberBand);
     QWidget* chartTab = new QWidget(this);
     QVBoxLayout* chartLayout = new QVBoxLayout(chartTab);
     chartLayout->addWidget(m_chartView);
@@ -46,17 +153,27 @@ void StiffOdeWidget::setupUi()
 
     QWidget* tableTab = new QWidget(this);
     QVBoxLayout* tableLayout = new QVBoxLayout(tableTab);
-    tableLayout->addWidget(m_tableWidget);
+    tableLayout->addWidget(m_tableView);
+
+    QHBoxLayout* summaryLayout = new QHBoxLayout();
 
     m_errorSummaryText = new QTextEdit(this);
     m_errorSummaryText->setReadOnly(true);
     m_errorSummaryText->setMaximumHeight(150);
-    tableLayout->addWidget(m_errorSummaryText);
+    summaryLayout->addWidget(m_errorSummaryText);
+
+    m_statisticsText = new QTextEdit(this);
+    m_statisticsText->setReadOnly(true);
+    m_statisticsText->setMaximumHeight(150);
+    summaryLayout->addWidget(m_statisticsText);
+
+    tableLayout->addLayout(summaryLayout);
 
     tableTab->setLayout(tableLayout);
 
     QChartView* exactChartView = new QChartView(this);
     exactChartView->setChart(m_exactChart);
+    exactChartView->setRubberBand(QChartView::RectangleRubberBand);
     QWidget* exactChartTab = new QWidget(this);
     QVBoxLayout* exactChartLayout = new QVBoxLayout(exactChartTab);
     exactChartLayout->addWidget(exactChartView);
@@ -64,6 +181,7 @@ void StiffOdeWidget::setupUi()
 
     QChartView* globalErrorChartView = new QChartView(this);
     globalErrorChartView->setChart(m_globalErrorChart);
+    globalErrorChartView->setRubberBand(QChartView::RectangleRubberBand);
     QWidget* errorChartTab = new QWidget(this);
     QVBoxLayout* errorChartLayout = new QVBoxLayout(errorChartTab);
     errorChartLayout->addWidget(globalErrorChartView);
@@ -89,89 +207,37 @@ void StiffOdeWidget::setupUi()
 }
 
 
-void StiffOdeWidget::populateTableAndChart()
+void StiffOdeWidget::populateTableAndChart(const StiffOdeWidgetData& data)
 {
-    const auto& seriesList = m_model->getSeries();
-    const auto exactSolution = m_model->computeExactSolution();
-    const auto globalErrors = m_model->computeGlobalError();
+    const auto& trajectory = m_model->getTrajectoryData();
+    const auto& globalErrors = m_model->computeGlobalError();
 
-    if (seriesList.empty() || exactSolution.empty() || globalErrors.empty())
+    if (trajectory.empty() || m_model->exactGridSize() == 0 || globalErrors.empty())
         return;
 
-    int numPoints = seriesList[0]->count();
-    int numVariables = static_cast<int>(seriesList.size());
-
-    m_tableWidget->setRowCount(numPoints);
-    m_tableWidget->setColumnCount(2 + numVariables * 3);
-
-    for (int col = 0; col < m_tableWidget->columnCount(); ++col)
-    {
-        m_tableWidget->setColumnWidth(col, 25 * QFontMetrics(m_tableWidget->font()).horizontalAdvance('0'));
-    }
+    int numVariables = static_cast<int>(trajectory.numComponents());
 
-    QStringList headers;
-    headers << "n" << "x_n";
-    for (int i = 0; i < numVariables; ++i)
-    {
-        headers << QString("u(%1) (точное)").arg(i + 1);
-    }
-    for (int i = 0; i < numVariables; ++i)
-    {
-        headers << QString("u(%1) (численное)").arg(i + 1);
-    }
-    for (int i = 0; i < numVariables; ++i)
-    {
-        headers << QString("E (погрешность)").arg(i + 1);
-    }
-    m_tableWidget->setHorizontalHeaderLabels(headers);
-    m_tableWidget->verticalHeader()->setVisible(false);
+    m_tableView->setModel(new TrajectoryTableModel(*m_model, m_tableView));
+    m_tableView->verticalHeader()->setVisible(false);
 
-    for (int i = 0; i < numPoints; ++i)
+    for (int col = 0; col < m_tableView->model()->columnCount(); ++col)
     {
-        QTableWidgetItem* rowIndexItem = new QTableWidgetItem(QString::number(i));
-        m_tableWidget->setItem(i, 0, rowIndexItem);
-        QTableWidgetItem* timeItem = new QTableWidgetItem(QString::number(seriesList[0]->at(i).x(), 'g', 16));
-        m_tableWidget->setItem(i, 1, timeItem);
-
-        for (int j = 0; j < numVariables; ++j)
-        {
-            double exactValue = exactSolution[i * numVariables + j].y();
-            QTableWidgetItem* exactItem = new QTableWidgetItem(QString::number(exactValue, 'g', 16));
-            m_tableWidget->setItem(i, 2 + j, exactItem);
-        }
-
-        for (int j = 0; j < numVariables; ++j)
-        {
-            double numericalValue = seriesList[j]->at(i).y();
-            QTableWidgetItem* numericalItem = new QTableWidgetItem(QString::number(numericalValue, 'g', 16));
-            m_tableWidget->setItem(i, 2 + numVariables + j, numericalItem);
-        }
-
-        for (int j = 0; j < numVariables; ++j)
-        {
-            double errorValue = globalErrors[j][i].y();
-            QTableWidgetItem* errorItem = new QTableWidgetItem(QString::number(errorValue, 'g', 16));
-            m_tableWidget->setItem(i, 2 + 2 * numVariables + j, errorItem);
-        }
+        m_tableView->setColumnWidth(col, 25 * QFontMetrics(m_tableView->font()).horizontalAdvance('0'));
     }
 
     m_chart->removeAllSeries();
+    auto* decimator = new ChartDecimator(m_chart);
     for (int j = 0; j < numVariables; ++j)
     {
         auto series = new QtCharts::QLineSeries();
         series->setName(QString("u(%1)").arg(j + 1));
-
-        for (int i = 0; i < numPoints; ++i)
-        {
-            double xValue = seriesList[0]->at(i).x();
-            double yValue = seriesList[j]->at(i).y();
-            series->append(xValue, yValue);
-        }
+        decimator->addSeries(series, trajectory.size(), componentPointAt(trajectory, j), data.solution[j]);
 
         m_chart->addSeries(series);
     }
 
     m_chart->createDefaultAxes();
+    decimator->track();
     auto* axisY = qobject_cast<QtCharts::QValueAxis*>(m_chart->axes(Qt::Vertical).first());
     if (axisY)
     {
@@ -186,10 +252,10 @@ void StiffOdeWidget::populateTableAndChart()
     m_chart->setTitle("Решение жёсткой системы ОДУ");
 }
 
-void StiffOdeWidget::populateExactChart()
+void StiffOdeWidget::populateExactChart(const StiffOdeWidgetData& data)
 {
-    const auto exactSolution = m_model->computeExactSolution();
-    if (exactSolution.empty())
+    const size_t exactCount = m_model->exactGridSize();
+    if (m_model->numComponents() < 2 || exactCount == 0)
         return;
 
     auto* seriesY0 = new QtCharts::QLineSeries();
@@ -198,31 +264,16 @@ void StiffOdeWidget::populateExactChart()
     seriesY0->setName("Точное решение u(1)");
     seriesY1->setName("Точное решение u(2)");
 
-    int SKIP_POINTS = 1;
-
-    if (m_model->getExactEndTime() > 999)
-    {
-        SKIP_POINTS = 10;
-    }
-    else
-    {
-        SKIP_POINTS = 1;
-    }
-
-    for (size_t i = 0; i < exactSolution.size(); i += 2 * SKIP_POINTS)
-    {
-        const auto& pointY0 = exactSolution[i];
-        const auto& pointY1 = exactSolution[i + 1];
-
-        seriesY0->append(pointY0.x(), pointY0.y());
-        seriesY1->append(pointY1.x(), pointY1.y());
-    }
+    auto* decimator = new ChartDecimator(m_exactChart);
+    decimator->addSeries(seriesY0, exactCount, exactPointAt(*m_model, 0), data.exact[0]);
+    decimator->addSeries(seriesY1, exactCount, exactPointAt(*m_model, 1), data.exact[1]);
 
     m_exactChart->removeAllSeries();
     m_exactChart->addSeries(seriesY0);
     m_exactChart->addSeries(seriesY1);
 
     m_exactChart->createDefaultAxes();
+    decimator->track();
 
     auto* axisY = qobject_cast<QtCharts::QValueAxis*>(m_exactChart->axes(Qt::Vertical).first());
     if (axisY) {
@@ -245,15 +296,15 @@ void StiffOdeWidget::populateExactChart()
     seriesY1->setPen(penY1);
 }
 
-void StiffOdeWidget::populateGlobalErrorChart()
+void StiffOdeWidget::populateGlobalErrorChart(const StiffOdeWidgetData& data)
 {
-    const auto globalErrors = m_model->computeGlobalError();
+    const auto& globalErrors = m_model->computeGlobalError();
     if (globalErrors.empty())
         return;
 
-    if (globalErrors.size() < 2)
+    if (globalErrors.errors.cols() < 2)
     {
-        m_errorSummaryText->setText("Недостаточно компонент для построения графиков глобальной погрешности.");
+        m_errorSummaryText->setText(data.errorSummary);
         return;
     }
 
@@ -267,47 +318,15 @@ void StiffOdeWidget::populateGlobalErrorChart()
     seriesY0->setColor(colors[0]);
     seriesY1->setColor(colors[1]);
 
-    double maxErrorY0 = std::numeric_limits<double>::lowest();
-    double minErrorY0 = std::numeric_limits<double>::max();
-    double maxErrorStepY0 = 0.0, minErrorStepY0 = 0.0;
+    auto* decimator = new ChartDecimator(m_globalErrorChart);
+    decimator->addSeries(seriesY0, globalErrors.times.size(), errorPointAt(globalErrors, 0), data.globalError[0]);
+    decimator->addSeries(seriesY1, globalErrors.times.size(), errorPointAt(globalErrors, 1), data.globalError[1]);
 
-    double maxErrorY1 = std::numeric_limits<double>::lowest();
-    double minErrorY1 = std::numeric_limits<double>::max();
-    double maxErrorStepY1 = 0.0, minErrorStepY1 = 0.0;
-
-    for (size_t i = 1; i < globalErrors[0].size(); ++i)
-    {
-        const auto& point = globalErrors[0][i];
-        seriesY0->append(point.x(), point.y());
-
-        if (point.y() > maxErrorY0) {
-            maxErrorY0 = point.y();
-            maxErrorStepY0 = point.x();
-        }
-        if (point.y() < minErrorY0) {
-            minErrorY0 = point.y();
-            minErrorStepY0 = point.x();
-        }
-    }
-
-    for (size_t i = 1; i < globalErrors[1].size(); ++i)
-    {
-        const auto& point = globalErrors[1][i];
-        seriesY1->append(point.x(), point.y());
-
-        if (point.y() > maxErrorY1) {
-            maxErrorY1 = point.y();
-            maxErrorStepY1 = point.x();
-        }
-        if (point.y() < minErrorY1) {
-            minErrorY1 = point.y();
-            minErrorStepY1 = point.x();
-        }
-    }
     m_globalErrorChart->removeAllSeries();
     m_globalErrorChart->addSeries(seriesY0);
     m_globalErrorChart->addSeries(seriesY1);
     m_globalErrorChart->createDefaultAxes();
+    decimator->track();
 
     auto* axisY = qobject_cast<QtCharts::QValueAxis*>(m_globalErrorChart->axes(Qt::Vertical).first());
     if (axisY)
@@ -323,26 +342,15 @@ void StiffOdeWidget::populateGlobalErrorChart()
 
     m_globalErrorChart->setTitle("График глобальной погрешности");
 
-    QString summaryText;
-
-    summaryText += QString("Первая компонента:\n");
-    summaryText += QString("  Максимальная погрешность: %1 в точке х =  %2\n").arg(maxErrorY0).arg(maxErrorStepY0);
-    summaryText += QString("  Минимальная погрешность: %1 в точке х =  %2\n").arg(minErrorY0).arg(minErrorStepY0);
-
-    summaryText += QString("\nВторая компонента:\n");
-    summaryText += QString("  Максимальная погрешность: %1 в точке х =  %2\n").arg(maxErrorY1).arg(maxErrorStepY1);
-    summaryText += QString("  Минимальная погрешность: %1 в точке х =  %2\n").arg(minErrorY1).arg(minErrorStepY1);
-    summaryText += QString("\nКоличество шагов: %1 \n").arg(globalErrors[1].size());
-
-    m_errorSummaryText->setText(summaryText);
+    m_errorSummaryText->setText(data.errorSummary);
 }
 
-void StiffOdeWidget::populateSolutionComparisonChart()
+void StiffOdeWidget::populateSolutionComparisonChart(const StiffOdeWidgetData& data)
 {
-    const auto& numericalSeries = m_model->getSeries();
-    const auto exactSolution = m_model->computeExactSolution();
+    const auto& trajectory = m_model->getTrajectoryData();
+    const size_t exactCount = m_model->exactGridSize();
 
-    if (numericalSeries.empty() || exactSolution.empty())
+    if (trajectory.numComponents() < 2 || trajectory.empty() || m_model->numComponents() < 2 || exactCount == 0)
         return;
 
     auto* numericalY0 = new QtCharts::QLineSeries();
@@ -355,21 +363,10 @@ void StiffOdeWidget::populateSolutionComparisonChart()
     exactY0->setName("Точное решение u(1)");
     exactY1->setName("Точное решение u(2)");
 
-    int numPoints = numericalSeries[0]->count();
-    for (int i = 0; i < numPoints; ++i)
-    {
-        double t = numericalSeries[0]->at(i).x();
-        numericalY0->append(t, numericalSeries[0]->at(i).y());
-        numericalY1->append(t, numericalSeries[1]->at(i).y());
-    }
-
-    for (size_t i = 0; i < exactSolution.size(); i += 2)
-    {
-        exactY0->append(exactSolution[i].x(), exactSolution[i].y());
-        exactY1->append(exactSolution[i + 1].x(), exactSolution[i + 1].y());
-    }
-
     QChart* chartY0 = new QChart();
+    auto* decimatorY0 = new ChartDecimator(chartY0);
+    decimatorY0->addSeries(numericalY0, trajectory.size(), componentPointAt(trajectory, 0), data.solution[0]);
+    decimatorY0->addSeries(exactY0, exactCount, exactPointAt(*m_model, 0), data.exact[0]);
     chartY0->addSeries(numericalY0);
     chartY0->addSeries(exactY0);
 
@@ -388,8 +385,12 @@ void StiffOdeWidget::populateSolutionComparisonChart()
     exactY0->attachAxis(axisY0);
 
     chartY0->setTitle("Решение первой компоненты");
+    decimatorY0->track();
 
     QChart* chartY1 = new QChart();
+    auto* decimatorY1 = new ChartDecimator(chartY1);
+    decimatorY1->addSeries(numericalY1, trajectory.size(), componentPointAt(trajectory, 1), data.solution[1]);
+    decimatorY1->addSeries(exactY1, exactCount, exactPointAt(*m_model, 1), data.exact[1]);
     chartY1->addSeries(numericalY1);
     chartY1->addSeries(exactY1);
 
@@ -408,6 +409,7 @@ void StiffOdeWidget::populateSolutionComparisonChart()
     exactY1->attachAxis(axisY1);
 
     chartY1->setTitle("Решение второй компоненты");
+    decimatorY1->track();
 
     auto* layout = qobject_cast<QVBoxLayout*>(m_solutionComparisonTab->layout());
     if (layout)
@@ -420,6 +422,8 @@ void StiffOdeWidget::populateSolutionComparisonChart()
 
         QChartView* chartViewY0 = new QChartView(chartY0);
         QChartView* chartViewY1 = new QChartView(chartY1);
+        chartViewY0->setRubberBand(QChartView::RectangleRubberBand);
+        chartViewY1->setRubberBand(QChartView::RectangleRubberBand);
 
         layout->addWidget(chartViewY0);
         layout->addWidget(chartViewY1);
@@ -428,44 +432,13 @@ void StiffOdeWidget::populateSolutionComparisonChart()
 
 void StiffOdeWidget::populateExactValuesTable()
 {
-    const auto exactSolution = m_model->computeExactSolution();
-    if (exactSolution.empty())
+    if (m_model->exactGridSize() == 0)
         return;
 
-    QTableWidget* exactValuesTable = new QTableWidget(this);
-    exactValuesTable->setRowCount(exactSolution.size() / 2);
-    exactValuesTable->setColumnCount(6);
-
-    QStringList headers;
-    headers << "n" << "x_n" << "exp(-0.01 * x)" << "exp(-1000 * x)" << "u(1) (точное)" << "u(2) (точное)";
-    exactValuesTable->setHorizontalHeaderLabels(headers);
+    QTableView* exactValuesTable = new QTableView(this);
+    exactValuesTable->setModel(new ExactValuesTableModel(*m_model, exactValuesTable));
     exactValuesTable->verticalHeader()->setVisible(false);
 
-    for (size_t i = 0; i < exactSolution.size() / 2; ++i)
-    {
-        double t = exactSolution[i * 2].x();
-        double u1 = exactSolution[i * 2].y();
-        double u2 = exactSolution[i * 2 + 1].y();
-
-        QTableWidgetItem* rowIndexItem = new QTableWidgetItem(QString::number(i));
-        exactValuesTable->setItem(i, 0, rowIndexItem);
-
-        QTableWidgetItem* timeItem = new QTableWidgetItem(QString::number(t, 'f', 16));
-        exactValuesTable->setItem(i, 1, timeItem);
-
-        QTableWidgetItem* expSmallItem = new QTableWidgetItem(QString::number(exp(-0.01 * t), 'f', 16));
-        exactValuesTable->setItem(i, 2, expSmallItem);
-
-        QTableWidgetItem* expLargeItem = new QTableWidgetItem(QString::number(exp(-1000 * t), 'e', 16));
-        exactValuesTable->setItem(i, 3, expLargeItem);
-
-        QTableWidgetItem* exactU1Item = new QTableWidgetItem(QString::number(u1, 'f', 16));
-        exactValuesTable->setItem(i, 4, exactU1Item);
-
-        QTableWidgetItem* exactU2Item = new QTableWidgetItem(QString::number(u2, 'f', 16));
-        exactValuesTable->setItem(i, 5, exactU2Item);
-    }
-
     exactValuesTable->horizontalHeader()->setMinimumSectionSize(25 * QFontMetrics(exactValuesTable->font()).horizontalAdvance('0'));
 
 
@@ -481,4 +454,32 @@ void StiffOdeWidget::populateExactValuesTable()
     }
 }
 
+void StiffOdeWidget::populateStatistics()
+{
+    if (!statisticsEnabled) {
+        m_statisticsText->setText("Счётчики отключены при сборке (STIFF_ODE_NO_STATISTICS).");
+        return;
+    }
+
+    const RunStatistics& statistics = m_model->getStatistics();
+    const SolverStatistics& solver = statistics.solver;
+    const PhaseTimings& phases = statistics.phases;
+
+    QString text;
+    text += QString("Вычислений правой части: %1\n").arg(solver.rhsEvaluations);
+    text += QString("Вычислений Якобиана: %1\n").arg(solver.jacobianEvaluations);
+    text += QString("LU-разложений: %1, решений линейных систем: %2\n")
+                .arg(solver.factorizations).arg(solver.linearSolves);
+    text += QString("Итераций Ньютона: %1\n").arg(solver.newtonIterations);
+    text += QString("Принятых шагов: %1, отклонённых шагов: %2\n")
+                .arg(solver.acceptedSteps).arg(solver.rejectedSteps);
+    text += QString("Переключений явный/неявный метод: %1\n").arg(solver.methodSwitches);
+
+    text += QString("\nРешение: %1 мс\n").arg(1000.0 * phases.solveSeconds, 0, 'f', 3);
+    text += QString("Глобальная погрешность: %1 мс\n").arg(1000.0 * phases.globalErrorSeconds, 0, 'f', 3);
+    text += QString("Данные графиков: %1 мс\n").arg(1000.0 * phases.chartDataSeconds, 0, 'f', 3);
+    text += QString("Графики и таблицы: %1 мс\n").arg(1000.0 * phases.uiSeconds, 0, 'f', 3);
+
+    m_statisticsText->setText(text);
+}
 }
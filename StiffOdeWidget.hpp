@@ -1,35 +1,56 @@
 #pragma once
 
-#include <QWidget>
+#include <QPointF>
+#include <QString>
 #include <QTextEdit>
+#include <QVector>
+#include <QWidget>
 #include <QtCharts/QChart>
 #include <QtCharts/QChartView>
 #include <QtCharts/QLineSeries>
 
-QT_FORWARD_DECLARE_CLASS(QTableWidget);
+QT_FORWARD_DECLARE_CLASS(QTableView);
 
 using namespace QtCharts;
 
 namespace StiffOde
 {
 class StiffOdeModel;
+
+// Содержимое графиков и сводки, подготовленное вне GUI-потока: прореженные по всему диапазону x
+// точки каждой компоненты численного решения, точного решения и глобальной погрешности
+struct StiffOdeWidgetData
+{
+    QVector<QVector<QPointF>> solution;
+    QVector<QVector<QPointF>> exact;
+    QVector<QVector<QPointF>> globalError;
+    QString errorSummary;
+};
+
 class StiffOdeWidget : public QWidget
 {
     Q_OBJECT
 
 public:
-    explicit StiffOdeWidget(StiffOdeModel* model, QWidget* parent = nullptr);
+    // data - результат prepare() для той же модели
+    StiffOdeWidget(StiffOdeModel* model, const StiffOdeWidgetData& data, QWidget* parent = nullptr);
+
+    // Прореживание всех серий параллельно в пуле потоков; вызывается в рабочем потоке после
+    // computeGlobalError(), GUI-потоку остаётся одна замена точек на серию. Точное решение считается
+    // в узлах по ходу прореживания и целиком не хранится
+    static StiffOdeWidgetData prepare(StiffOdeModel& model);
 
 private:
     void setupUi();
-    void populateTableAndChart();
-    void populateExactChart();
-    void populateGlobalErrorChart();
-    void populateSolutionComparisonChart();
+    void populateTableAndChart(const StiffOdeWidgetData& data);
+    void populateExactChart(const StiffOdeWidgetData& data);
+    void populateGlobalErrorChart(const StiffOdeWidgetData& data);
+    void populateSolutionComparisonChart(const StiffOdeWidgetData& data);
     void populateExactValuesTable();
+    void populateStatistics();
 
     StiffOdeModel* m_model;
-    QTableWidget* m_tableWidget;
+    QTableView* m_tableView;
     QWidget* m_exactValuesTab;
     QChartView* m_chartView;
     QChart* m_chart;
@@ -37,6 +58,7 @@ private:
     QChart* m_globalErrorChart;
     QWidget* m_solutionComparisonTab;
     QTextEdit* m_errorSummaryText;
+    QTextEdit* m_statisticsText;
 
 };
 }
@@ -1,13 +1,24 @@
+#include <QDebug>
 #include <QLabel>
+#include <QComboBox>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <cmath>
+#include <memory>
 #include <QGroupBox>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QPushButton>
 #include <QLineSeries>
+#include <QThreadPool>
+#include <QProgressBar>
+#include <QFutureWatcher>
 #include <QDoubleSpinBox>
+#include <QtConcurrent/QtConcurrent>
 #include <QtCharts/QChartView>
 
 #include "mainwindow.h"
+#include "StiffOdeConvergenceWidget.hpp"
 #include "StiffOdeModel.hpp"
 #include "StiffOdeWidget.hpp"
 
@@ -37,36 +48,111 @@ MainWindow::MainWindow(QWidget *parent)
     QPushButton *createModelButton = new QPushButton("Создать", this);
     buttonLayout->addWidget(createModelButton);
 
-    mainLayout->addLayout(buttonLayout);
+    QPushButton *openButton = new QPushButton("Открыть", this);
+    buttonLayout->addWidget(openButton);
 
-    connect(createModelButton, &QPushButton::clicked, this, [=]() {
-        if (m_model != nullptr)
-            delete m_model;
-        if (m_widget != nullptr) {
-            centralWidget->layout()->removeWidget(m_widget);
-            delete m_widget;
-        }
-        double stepSize = m_stepSizeSpinBox->value();
-        double startTime = m_startTimeSpinBox->value();
-        double endTime = m_endTimeSpinBox->value();
-        double endExactTime = m_endExactTimeSpinBox->value();
-        double startExactTime = m_startExactTimeSpinBox->value();
+    QPushButton *saveButton = new QPushButton("Сохранить", this);
+    buttonLayout->addWidget(saveButton);
+
+    QPushButton *saveCheckpointButton = new QPushButton("Сохранить состояние", this);
+    buttonLayout->addWidget(saveCheckpointButton);
+
+    QPushButton *resumeButton = new QPushButton("Продолжить из состояния", this);
+    buttonLayout->addWidget(resumeButton);
+
+    // На равномерной сетке с шагом из поля "Размер шага" или в узлах решения вместе с чувствительностями
+    QPushButton *exportButton = new QPushButton("Экспорт CSV с шагом", this);
+    buttonLayout->addWidget(exportButton);
+    QPushButton *exportNodesButton = new QPushButton("Экспорт CSV в узлах", this);
+    buttonLayout->addWidget(exportNodesButton);
 
-        m_model= new StiffOde::StiffOdeModel(this);
-        m_model->setInitialConditions({7, 13}, startTime);
-        m_model->setParameters(stepSize, endTime, endExactTime, startExactTime);
-        m_model->solve();
+    QPushButton *ensembleButton = new QPushButton("Ансамбль", this);
+    buttonLayout->addWidget(ensembleButton);
 
-        m_widget = new StiffOde::StiffOdeWidget(m_model, this);
+    QPushButton *convergenceButton = new QPushButton("Сходимость", this);
+    buttonLayout->addWidget(convergenceButton);
+
+    m_cancelButton = new QPushButton("Отмена", this);
+    m_cancelButton->setEnabled(false);
+    buttonLayout->addWidget(m_cancelButton);
+
+    m_progressBar = new QProgressBar(this);
+    m_progressBar->setRange(0, 100);
+    m_progressBar->setVisible(false);
+    buttonLayout->addWidget(m_progressBar);
+
+    mainLayout->addLayout(buttonLayout);
 
-        centralWidget->layout()->addWidget(m_widget);
+    connect(createModelButton, &QPushButton::clicked, this, [this]() {
+        startRun();
+    });
+    connect(openButton, &QPushButton::clicked, this, [this]() {
+        const QString path = QFileDialog::getOpenFileName(this, "Открыть траекторию", QString(),
+                                                          "Траектории (*.sode)");
+        if (!path.isEmpty())
+            startRun(path);
+    });
+    connect(saveButton, &QPushButton::clicked, this, [this]() {
+        if (m_model == nullptr)
+            return;
+        const QString path = QFileDialog::getSaveFileName(this, "Сохранить траекторию", QString(),
+                                                          "Траектории (*.sode)");
+        if (!path.isEmpty() && !m_model->saveTrajectory(path))
+            QMessageBox::warning(this, "Ошибка", "Не удалось сохранить траекторию в " + path);
+    });
+    connect(saveCheckpointButton, &QPushButton::clicked, this, [this]() {
+        if (m_model == nullptr)
+            return;
+        const QString path = QFileDialog::getSaveFileName(this, "Сохранить состояние решателя", QString(),
+                                                          "Контрольные точки (*.sodc)");
+        if (!path.isEmpty() && !m_model->saveCheckpoint(path))
+            QMessageBox::warning(this, "Ошибка", "Не удалось сохранить состояние в " + path);
+    });
+    connect(resumeButton, &QPushButton::clicked, this, [this]() {
+        const QString path = QFileDialog::getOpenFileName(this, "Продолжить из состояния", QString(),
+                                                          "Контрольные точки (*.sodc)");
+        if (!path.isEmpty())
+            startRun(QString(), path);
+    });
+    const auto exportCsv = [this](double sampleStep) {
+        if (m_model == nullptr)
+            return;
+        const QString path = QFileDialog::getSaveFileName(this, "Экспорт в CSV", QString(), "CSV (*.csv)");
+        if (!path.isEmpty() && !m_model->exportCsv(path, sampleStep))
+            QMessageBox::warning(this, "Ошибка", "Не удалось записать " + path);
+    };
+    connect(exportButton, &QPushButton::clicked, this, [this, exportCsv]() {
+        exportCsv(m_stepSizeSpinBox->value());
+    });
+    connect(exportNodesButton, &QPushButton::clicked, this, [exportCsv]() {
+        exportCsv(0.0);
+    });
+    connect(ensembleButton, &QPushButton::clicked, this, &MainWindow::startEnsemble);
+    connect(convergenceButton, &QPushButton::clicked, this, &MainWindow::startConvergenceStudy);
+    connect(m_cancelButton, &QPushButton::clicked, this, [this]() {
+        if (m_pendingModel != nullptr)
+            m_pendingModel->cancel();
+        if (m_studyModel)
+            m_studyModel->cancel();
+        if (m_ensembleModel)
+            m_ensembleModel->cancel();
     });
 }
 
 MainWindow::~MainWindow()
 {
-    delete m_model;
+    // Незавершённый расчёт прерывается, модели расчётов удаляются вместе со своими QFutureWatcher
+    if (m_pendingModel != nullptr)
+        m_pendingModel->cancel();
+    if (m_studyModel)
+        m_studyModel->cancel();
+    if (m_ensembleModel)
+        m_ensembleModel->cancel();
+    QThreadPool::globalInstance()->waitForDone();
+
+    // Графики обращаются к данным модели, поэтому виджет удаляется первым
     delete m_widget;
+    delete m_model;
     Ui::MainWindow *ui;
     delete m_stepSizeSpinBox;
     delete m_startTimeSpinBox;
@@ -146,6 +232,232 @@ QHBoxLayout* MainWindow::createGroupbox()
     groupBoxLayout2->addLayout(inputLayout2);
     groupBoxesLayout->addWidget(inputGroupBox2);
 
+    QGroupBox *inputGroupBox3 = new QGroupBox("Метод", this);
+    QVBoxLayout *groupBoxLayout3 = new QVBoxLayout(inputGroupBox3);
+    groupBoxLayout3->setSpacing(10);
+
+    QHBoxLayout *inputLayout3 = new QHBoxLayout();
+    inputLayout3->setSpacing(10);
+
+    m_methodComboBox = new QComboBox(this);
+    m_methodComboBox->addItem("Неявный Эйлер", static_cast<int>(StiffOde::Method::BackwardEuler));
+    m_methodComboBox->addItem("TR-BDF2", static_cast<int>(StiffOde::Method::TrBdf2));
+    m_methodComboBox->addItem("BDF 1-5", static_cast<int>(StiffOde::Method::Bdf));
+    m_methodComboBox->addItem("Radau IIA", static_cast<int>(StiffOde::Method::Radau5));
+    m_methodComboBox->addItem("Экспоненциальный Розенброк",
+                              static_cast<int>(StiffOde::Method::ExponentialRosenbrock));
+    m_methodComboBox->addItem("Автовыбор (Дорманд - Принс / BDF)", static_cast<int>(StiffOde::Method::Automatic));
+    inputLayout3->addWidget(m_methodComboBox);
+
+    QLabel *toleranceLabel = new QLabel("Допуск:", this);
+    m_toleranceComboBox = new QComboBox(this);
+    for (int exponent = 3; exponent <= 10; ++exponent)
+        m_toleranceComboBox->addItem(QString("1e-%1").arg(exponent), std::pow(10.0, -exponent));
+    m_toleranceComboBox->setCurrentIndex(3);
+    // Неявный метод Эйлера идёт с постоянным шагом и допуск не использует
+    m_toleranceComboBox->setEnabled(false);
+    inputLayout3->addWidget(toleranceLabel);
+    inputLayout3->addWidget(m_toleranceComboBox);
+
+    connect(m_methodComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this]() {
+        const auto method = static_cast<StiffOde::Method>(m_methodComboBox->currentData().toInt());
+        m_toleranceComboBox->setEnabled(method != StiffOde::Method::BackwardEuler);
+    });
+
+    groupBoxLayout3->addLayout(inputLayout3);
+    groupBoxesLayout->addWidget(inputGroupBox3);
+
     return groupBoxesLayout;
 }
 
+void MainWindow::startRun(const QString& trajectoryPath, const QString& checkpointPath)
+{
+    // Предыдущий расчёт не удаляется, а прерывается: его модель освободится, когда он завершится
+    if (m_pendingModel != nullptr)
+        m_pendingModel->cancel();
+
+    double stepSize = m_stepSizeSpinBox->value();
+    double startTime = m_startTimeSpinBox->value();
+    double endTime = m_endTimeSpinBox->value();
+    double endExactTime = m_endExactTimeSpinBox->value();
+    double startExactTime = m_startExactTimeSpinBox->value();
+    const auto method = static_cast<StiffOde::Method>(m_methodComboBox->currentData().toInt());
+    const double relTolerance = m_toleranceComboBox->currentData().toDouble();
+
+    auto* watcher = new QFutureWatcher<StiffOde::StiffOdeWidgetData>(this);
+    auto* model = new StiffOde::StiffOdeModel(watcher);
+    model->setInitialConditions({7, 13}, startTime);
+    model->setParameters(stepSize, endTime, endExactTime, startExactTime);
+    model->setMethod(method, relTolerance, relTolerance * 1e-3);
+
+    if (!checkpointPath.isEmpty()) {
+        if (!model->loadCheckpoint(checkpointPath)) {
+            QMessageBox::warning(this, "Ошибка", "Не удалось прочитать состояние из " + checkpointPath);
+            delete watcher;
+            return;
+        }
+    }
+    // Если изменился только конец отрезка и он увеличился, решение продолжается с конца прошлого,
+    // а не считается заново; графики строятся по дополненной траектории
+    else if (trajectoryPath.isEmpty() && m_model != nullptr && model->continueFrom(*m_model))
+        qDebug() << "Continuing previous solution to t =" << endTime;
+    m_pendingModel = model;
+
+    connect(model, &StiffOde::StiffOdeModel::progressChanged, this, [this, model](int percent) {
+        if (model == m_pendingModel)
+            m_progressBar->setValue(percent);
+    });
+    connect(watcher, &QFutureWatcher<StiffOde::StiffOdeWidgetData>::finished, this, [this, watcher, model]() {
+        finishRun(model, watcher->result());
+        watcher->deleteLater();
+    });
+
+    m_progressBar->setValue(0);
+    m_progressBar->setVisible(true);
+    m_cancelButton->setEnabled(true);
+
+    // Решение, точное решение, погрешность и точки графиков считаются в рабочем потоке;
+    // GUI-поток получает готовую модель и прореженные серии
+    watcher->setFuture(QtConcurrent::run([model, trajectoryPath]() {
+        if (trajectoryPath.isEmpty())
+            model->solve();
+        else if (!model->loadTrajectory(trajectoryPath)) {
+            qDebug() << "Cannot read trajectory file" << trajectoryPath;
+            model->cancel();
+            return StiffOde::StiffOdeWidgetData();
+        }
+        model->computeGlobalError();
+        if (model->isCancelled())
+            return StiffOde::StiffOdeWidgetData();
+        return StiffOde::StiffOdeWidget::prepare(*model);
+    }));
+}
+
+void MainWindow::finishRun(StiffOde::StiffOdeModel* model, const StiffOde::StiffOdeWidgetData& data)
+{
+    if (model != m_pendingModel)
+        return;
+
+    m_pendingModel = nullptr;
+    m_progressBar->setVisible(false);
+    updateCancelButton();
+
+    if (model->isCancelled())
+        return;
+
+    if (m_widget != nullptr) {
+        centralWidget()->layout()->removeWidget(m_widget);
+        delete m_widget;
+    }
+    delete m_model;
+
+    // Модель переходит от QFutureWatcher к окну и переживает удаление watcher
+    model->setParent(this);
+    m_model = model;
+    m_widget = new StiffOde::StiffOdeWidget(m_model, data, this);
+
+    centralWidget()->layout()->addWidget(m_widget);
+}
+
+void MainWindow::updateCancelButton()
+{
+    m_cancelButton->setEnabled(m_pendingModel != nullptr || m_studyModel || m_ensembleModel);
+}
+
+void MainWindow::startEnsemble()
+{
+    const int gridSize = 100;
+
+    auto model = std::make_shared<StiffOde::StiffOdeModel>();
+    model->setInitialConditions({7, 13}, m_startTimeSpinBox->value());
+    model->setParameters(m_stepSizeSpinBox->value(), m_endTimeSpinBox->value(), m_endExactTimeSpinBox->value(),
+                         m_startExactTimeSpinBox->value());
+    model->setMethod(StiffOde::Method::TrBdf2, 1e-6, 1e-9);
+
+    // Равномерная сетка начальных условий [0, 14] x [0, 26]
+    StiffOde::Matrix initialConditions(2, gridSize * gridSize);
+    for (int i = 0; i < gridSize; ++i) {
+        for (int j = 0; j < gridSize; ++j) {
+            initialConditions(0, i * gridSize + j) = 14.0 * i / (gridSize - 1);
+            initialConditions(1, i * gridSize + j) = 26.0 * j / (gridSize - 1);
+        }
+    }
+
+    if (m_ensembleModel)
+        m_ensembleModel->cancel();
+    m_ensembleModel = model;
+    m_cancelButton->setEnabled(true);
+
+    auto* watcher = new QFutureWatcher<StiffOde::EnsembleResult>(this);
+    connect(watcher, &QFutureWatcher<StiffOde::EnsembleResult>::finished, this, [this, watcher, model]() {
+        watcher->deleteLater();
+        if (model == m_ensembleModel) {
+            m_ensembleModel.reset();
+            updateCancelButton();
+        }
+        if (model->isCancelled())
+            return;
+
+        const StiffOde::EnsembleResult result = watcher->result();
+        QMessageBox::information(this, "Ансамбль",
+                                 QString("Траекторий: %1\nВремя: %2 с\nТраекторий в секунду: %3\n"
+                                         "Принятых шагов: %4, отклонённых шагов: %5")
+                                     .arg(result.status.size())
+                                     .arg(result.elapsedSeconds)
+                                     .arg(result.trajectoriesPerSecond, 0, 'f', 0)
+                                     .arg(result.acceptedSteps)
+                                     .arg(result.rejectedSteps));
+    });
+    watcher->setFuture(QtConcurrent::run([model, initialConditions]() {
+        return model->solveEnsemble(initialConditions);
+    }));
+}
+
+void MainWindow::startConvergenceStudy()
+{
+    const size_t runCount = 8;
+
+    const auto method = static_cast<StiffOde::Method>(m_methodComboBox->currentData().toInt());
+    const double relTolerance = m_toleranceComboBox->currentData().toDouble();
+
+    auto model = std::make_shared<StiffOde::StiffOdeModel>();
+    model->setInitialConditions({7, 13}, m_startTimeSpinBox->value());
+    model->setParameters(m_stepSizeSpinBox->value(), m_endTimeSpinBox->value(), m_endExactTimeSpinBox->value(),
+                         m_startExactTimeSpinBox->value());
+    model->setMethod(method, relTolerance, relTolerance * 1e-3);
+
+    // Постоянный шаг уменьшается вдвое начиная с заданного, допуск адаптивных методов - от 1e-3 до 1e-10
+    const bool byStep = method == StiffOde::Method::BackwardEuler;
+    const StiffOde::StudyParameter parameter = byStep ? StiffOde::StudyParameter::StepSize
+                                                      : StiffOde::StudyParameter::Tolerance;
+    const double first = byStep ? m_stepSizeSpinBox->value() : 1e-3;
+    const double ratio = byStep ? 0.5 : 0.1;
+
+    // Предыдущее исследование прерывается, как и предыдущий расчёт в startRun
+    if (m_studyModel)
+        m_studyModel->cancel();
+    m_studyModel = model;
+    m_cancelButton->setEnabled(true);
+
+    auto* watcher = new QFutureWatcher<StiffOde::ConvergenceStudyResult>(this);
+    connect(watcher, &QFutureWatcher<StiffOde::ConvergenceStudyResult>::finished, this,
+            [this, watcher, model, parameter]() {
+        watcher->deleteLater();
+        if (model == m_studyModel) {
+            m_studyModel.reset();
+            updateCancelButton();
+        }
+        if (model->isCancelled())
+            return;
+
+        auto* studyWidget = new StiffOde::StiffOdeConvergenceWidget(watcher->result(), parameter, this);
+        studyWidget->setWindowFlags(Qt::Window);
+        studyWidget->setAttribute(Qt::WA_DeleteOnClose);
+        studyWidget->setWindowTitle("Исследование сходимости");
+        studyWidget->resize(1000, 700);
+        studyWidget->show();
+    });
+    watcher->setFuture(QtConcurrent::run([model, parameter, first, ratio]() {
+        return model->runConvergenceStudy(parameter, first, ratio, runCount);
+    }));
+}
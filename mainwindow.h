@@ -3,7 +3,12 @@
 #include "qspinbox.h"
 #include <QMainWindow>
 
+#include <memory>
+
+QT_FORWARD_DECLARE_CLASS(QComboBox);
 QT_FORWARD_DECLARE_CLASS(QHBoxLayout);
+QT_FORWARD_DECLARE_CLASS(QProgressBar);
+QT_FORWARD_DECLARE_CLASS(QPushButton);
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -14,6 +19,7 @@ namespace StiffOde
 {
 class StiffOdeModel;
 class StiffOdeWidget;
+struct StiffOdeWidgetData;
 }
 class MainWindow : public QMainWindow
 {
@@ -33,6 +39,27 @@ private:
     QDoubleSpinBox * m_endTimeSpinBox {nullptr};
     QDoubleSpinBox * m_endExactTimeSpinBox {nullptr};
     QDoubleSpinBox * m_startExactTimeSpinBox {nullptr};
+    QComboBox* m_methodComboBox {nullptr};
+    // Относительный допуск адаптивных методов; абсолютный в 1000 раз меньше
+    QComboBox* m_toleranceComboBox {nullptr};
+
+    QProgressBar* m_progressBar {nullptr};
+    QPushButton* m_cancelButton {nullptr};
+    // Модель расчёта, который ещё выполняется в рабочем потоке
+    StiffOde::StiffOdeModel* m_pendingModel {nullptr};
+    // Модели выполняющихся исследования сходимости и ансамбля; отменяются той же кнопкой
+    std::shared_ptr<StiffOde::StiffOdeModel> m_studyModel;
+    std::shared_ptr<StiffOde::StiffOdeModel> m_ensembleModel;
 
     QHBoxLayout* createGroupbox();
+    // Решение заново, продолжение прошлого решения при увеличении конца отрезка, загрузка сохранённой
+    // траектории или продолжение счёта из сохранённого состояния решателя
+    void startRun(const QString& trajectoryPath = QString(), const QString& checkpointPath = QString());
+    void finishRun(StiffOde::StiffOdeModel* model, const StiffOde::StiffOdeWidgetData& data);
+    // Кнопка отмены доступна, пока выполняется хотя бы один расчёт
+    void updateCancelButton();
+    // Решение для сетки начальных условий вокруг {7, 13} с отчётом о производительности
+    void startEnsemble();
+    // Серия решений текущим методом с убывающим шагом (неявный Эйлер) или допуском и оценка порядка
+    void startConvergenceStudy();
 };
@@ -1,5 +1,5 @@
 QT       += core gui
-QT       += widgets charts
+QT       += widgets charts concurrent
 
 INCLUDEPATH += C:\Qt\eigen-3.4.0
 
@@ -11,14 +11,22 @@ CONFIG += c++17
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+include(stiff_ode_core.pri)
+
 SOURCES += \
+    StiffOdeChartDecimator.cpp \
+    StiffOdeConvergenceWidget.cpp \
     StiffOdeModel.cpp \
+    StiffOdeTableModels.cpp \
     StiffOdeWidget.cpp \
     main.cpp \
     mainwindow.cpp
 
 HEADERS += \
+    StiffOdeChartDecimator.hpp \
+    StiffOdeConvergenceWidget.hpp \
     StiffOdeModel.hpp \
+    StiffOdeTableModels.hpp \
     StiffOdeWidget.hpp \
     mainwindow.h
 
@@ -0,0 +1,42 @@
+# Численное ядро без зависимостей от Qt: подключается через include() в GUI и в пакетных утилитах.
+INCLUDEPATH += $$PWD
+
+# Счётчики и таймеры решателя дешёвы и включены по умолчанию; так они удаляются из сборки:
+#DEFINES += STIFF_ODE_NO_STATISTICS
+
+SOURCES += \
+    $$PWD/StiffOdeCheckpointFile.cpp \
+    $$PWD/StiffOdeConvergence.cpp \
+    $$PWD/StiffOdeDenseOutput.cpp \
+    $$PWD/StiffOdeEnsemble.cpp \
+    $$PWD/StiffOdeEvents.cpp \
+    $$PWD/StiffOdeExponential.cpp \
+    $$PWD/StiffOdeGlobalError.cpp \
+    $$PWD/StiffOdeGrid.cpp \
+    $$PWD/StiffOdeLinearSolver.cpp \
+    $$PWD/StiffOdeNewton.cpp \
+    $$PWD/StiffOdePropagator.cpp \
+    $$PWD/StiffOdeSensitivity.cpp \
+    $$PWD/StiffOdeSolver.cpp \
+    $$PWD/StiffOdeTrajectory.cpp \
+    $$PWD/StiffOdeTrajectoryFile.cpp
+
+HEADERS += \
+    $$PWD/StiffOdeCheckpointFile.hpp \
+    $$PWD/StiffOdeConvergence.hpp \
+    $$PWD/StiffOdeDenseOutput.hpp \
+    $$PWD/StiffOdeEnsemble.hpp \
+    $$PWD/StiffOdeEvents.hpp \
+    $$PWD/StiffOdeExponential.hpp \
+    $$PWD/StiffOdeFixedSolver.hpp \
+    $$PWD/StiffOdeGlobalError.hpp \
+    $$PWD/StiffOdeGrid.hpp \
+    $$PWD/StiffOdeLinearSolver.hpp \
+    $$PWD/StiffOdeNewton.hpp \
+    $$PWD/StiffOdePropagator.hpp \
+    $$PWD/StiffOdeSensitivity.hpp \
+    $$PWD/StiffOdeSolver.hpp \
+    $$PWD/StiffOdeStatistics.hpp \
+    $$PWD/StiffOdeTrajectory.hpp \
+    $$PWD/StiffOdeTrajectoryFile.hpp \
+    $$PWD/StiffOdeTypes.hpp
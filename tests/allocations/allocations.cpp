@@ -0,0 +1,113 @@
+// Проверка отсутствия выделений памяти в цикле шагов: решение на коротком и длинном отрезке
+// должно выполнять одинаковое число выделений, то есть все они приходятся на подготовку solve().
+// Выделения считаются подменой malloc/calloc/realloc glibc, поэтому учитываются и Eigen, и operator new.
+
+#include "StiffOdeSolver.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+
+#ifdef __GLIBC__
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+
+namespace
+{
+std::atomic<size_t> allocationCount {0};
+}
+
+extern "C" void* malloc(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+#endif
+
+namespace
+{
+using namespace StiffOde;
+
+struct Run
+{
+    size_t allocations = 0;
+    size_t steps = 0;
+    SolveStatus status = SolveStatus::Finished;
+};
+
+// Осциллятор Ван дер Поля с mu = 10: жёсткий и нелинейный, так что Якобиан и разложение
+// обновляются по ходу решения, а число шагов растёт с длиной отрезка
+void vanDerPol(double, const double* y, double* dydt)
+{
+    const double mu = 10.0;
+    dydt[0] = y[1];
+    dydt[1] = mu * (1.0 - y[0] * y[0]) * y[1] - y[0];
+}
+
+Run solve(const StiffOdeSolver& solver, double endTime)
+{
+    Trajectory trajectory;
+    const std::vector<double> initialConditions { 2.0, 0.0 };
+
+    Run run;
+    const size_t before = allocationCount.load();
+    const SolveResult result = solver.solve(initialConditions, 0.0, endTime, trajectory);
+    run.allocations = allocationCount.load() - before;
+    run.steps = result.acceptedSteps + result.rejectedSteps;
+    run.status = result.status;
+    return run;
+}
+
+bool check(const char* name, Method method, double stepSize)
+{
+    StiffOdeSolver solver;
+    solver.setInPlaceSystem(vanDerPol);
+
+    SolverOptions options;
+    options.method = method;
+    options.stepSize = stepSize;
+    options.relTolerance = 1e-6;
+    options.absTolerance = 1e-8;
+    options.storeTrajectory = false;
+    solver.setOptions(options);
+
+    // Первый прогон прогревает ленивые статические данные библиотек
+    solve(solver, 1.0);
+    const Run shortRun = solve(solver, 5.0);
+    const Run longRun = solve(solver, 50.0);
+
+    const bool ok = shortRun.status == SolveStatus::Finished && longRun.status == SolveStatus::Finished
+                    && longRun.steps > 2 * shortRun.steps && shortRun.allocations == longRun.allocations;
+    std::printf("%-14s %s: %zu steps - %zu allocations, %zu steps - %zu allocations\n", name, ok ? "ok  " : "FAIL",
+                shortRun.steps, shortRun.allocations, longRun.steps, longRun.allocations);
+    return ok;
+}
+}
+
+int main()
+{
+#ifndef __GLIBC__
+    std::printf("Allocation counting requires glibc, skipped\n");
+    return 0;
+#else
+    bool ok = true;
+    ok = check("BackwardEuler", Method::BackwardEuler, 1e-3) && ok;
+    ok = check("TrBdf2", Method::TrBdf2, 0.0) && ok;
+    ok = check("Bdf", Method::Bdf, 0.0) && ok;
+    ok = check("Radau5", Method::Radau5, 0.0) && ok;
+    return ok ? 0 : 1;
+#endif
+}
@@ -0,0 +1,13 @@
+# Тест числа выделений памяти в цикле шагов; запускается через "make check"
+TEMPLATE = app
+TARGET = allocations
+QT -= core gui
+CONFIG += console c++17 testcase
+CONFIG -= app_bundle qt
+
+INCLUDEPATH += C:\Qt\eigen-3.4.0
+
+include(../../stiff_ode_core.pri)
+
+SOURCES += \
+    allocations.cpp
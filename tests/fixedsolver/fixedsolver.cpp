@@ -0,0 +1,130 @@
+// Проверка FixedSizeSolver: на линейной жёсткой системе y' = Ay размерности 2 и 8 неявный метод Эйлера
+// и TR-BDF2 должны давать те же узлы и значения, что и StiffOdeSolver, а остальные методы - отклоняться.
+
+#include "StiffOdeFixedSolver.hpp"
+#include "StiffOdeSolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+using namespace StiffOde;
+
+// Матрица по умолчанию из StiffOdeModel с собственными числами -0.01 и -1000, повторённая
+// по диагонали блоками с разным масштабом, чтобы компоненты различались
+template <int N>
+Eigen::Matrix<double, N, N> testMatrix()
+{
+    Eigen::Matrix<double, N, N> a = Eigen::Matrix<double, N, N>::Zero();
+    for (int k = 0; k + 1 < N; k += 2) {
+        const double scale = 1.0 + 0.5 * k;
+        a(k, k) = a(k + 1, k + 1) = -500.005 * scale;
+        a(k, k + 1) = a(k + 1, k) = 499.995 * scale;
+    }
+    return a;
+}
+
+template <int N>
+Eigen::Matrix<double, N, 1> testInitialConditions()
+{
+    Eigen::Matrix<double, N, 1> y0;
+    for (int i = 0; i < N; ++i)
+        y0[i] = i % 2 == 0 ? 7.0 + i : 13.0 - i;
+    return y0;
+}
+
+SolverOptions testOptions(Method method)
+{
+    SolverOptions options;
+    options.method = method;
+    options.stepSize = method == Method::BackwardEuler ? 1e-3 : 0.0;
+    options.relTolerance = 1e-6;
+    options.absTolerance = 1e-8;
+    return options;
+}
+
+template <int N>
+bool compare(const char* name, Method method)
+{
+    using Solver = FixedSizeSolver<N>;
+    using State = typename Solver::State;
+    using JacobianMatrix = typename Solver::JacobianMatrix;
+
+    const JacobianMatrix a = testMatrix<N>();
+    const State y0 = testInitialConditions<N>();
+    const double endTime = 2.0;
+
+    Solver fixedSolver;
+    fixedSolver.setOptions(testOptions(method));
+    Trajectory fixed;
+    const SolveResult fixedResult = fixedSolver.solve(
+        [&a](double, const State& y, State& dydt) { dydt.noalias() = a * y; },
+        [&a](double, const State&, JacobianMatrix& j) { j = a; }, y0, 0.0, endTime, fixed);
+
+    const Matrix matrix = a;
+    StiffOdeSolver solver;
+    solver.setInPlaceSystem([&matrix](double, const double* y, double* dydt)
+    {
+        Eigen::Map<Vector>(dydt, N).noalias() = matrix * Eigen::Map<const Vector>(y, N);
+    });
+    solver.setJacobian([&matrix](const std::vector<double>&, double) -> Matrix { return matrix; });
+    solver.setOptions(testOptions(method));
+    Trajectory reference;
+    const SolveResult referenceResult = solver.solve(std::vector<double>(y0.data(), y0.data() + N), 0.0, endTime,
+                                                     reference);
+
+    // Порядок операций с матрицами фиксированного и динамического размера различается, поэтому шаги TR-BDF2
+    // могут расходиться на уровне ошибок округления
+    double maxDifference = 0.0;
+    bool sameNodes = fixed.size() == reference.size();
+    for (size_t i = 0; sameNodes && i < fixed.size(); ++i) {
+        sameNodes = std::abs(fixed.time(i) - reference.time(i)) <= 1e-6 * endTime;
+        for (size_t j = 0; j < N; ++j)
+            maxDifference = std::max(maxDifference, std::abs(fixed.value(j, i) - reference.value(j, i)));
+    }
+
+    const SolverCheckpoint& checkpoint = fixedSolver.checkpoint();
+    const bool ok = fixedResult.status == SolveStatus::Finished && referenceResult.status == SolveStatus::Finished
+                    && fixedResult.acceptedSteps == referenceResult.acceptedSteps && sameNodes
+                    && maxDifference <= 1e-8 * y0.cwiseAbs().maxCoeff()
+                    && checkpoint.t == endTime && checkpoint.y.size() == N;
+    std::printf("%-14s N = %d %s: %zu/%zu steps, max difference %.3g\n", name, N, ok ? "ok  " : "FAIL",
+                fixedResult.acceptedSteps, referenceResult.acceptedSteps, maxDifference);
+    return ok;
+}
+
+bool rejects(const char* name, Method method, double stepSize)
+{
+    using Solver = FixedSizeSolver<2>;
+
+    SolverOptions options = testOptions(method);
+    options.stepSize = stepSize;
+    Solver solver;
+    solver.setOptions(options);
+    Trajectory trajectory;
+    const SolveResult result = solver.solve([](double, const Solver::State& y, Solver::State& dydt) { dydt = -y; },
+                                            Solver::State(1.0, 2.0), 0.0, 1.0, trajectory);
+
+    const bool ok = result.status == SolveStatus::InvalidOptions && result.acceptedSteps == 0;
+    std::printf("%-14s rejected %s\n", name, ok ? "ok" : "FAIL");
+    return ok;
+}
+}
+
+int main()
+{
+    bool ok = true;
+    ok = compare<2>("BackwardEuler", Method::BackwardEuler) && ok;
+    ok = compare<8>("BackwardEuler", Method::BackwardEuler) && ok;
+    ok = compare<2>("TrBdf2", Method::TrBdf2) && ok;
+    ok = compare<8>("TrBdf2", Method::TrBdf2) && ok;
+    ok = rejects("BackwardEuler", Method::BackwardEuler, 0.0) && ok;
+    ok = rejects("Bdf", Method::Bdf, 0.0) && ok;
+    ok = rejects("Radau5", Method::Radau5, 0.0) && ok;
+    ok = rejects("ExponentialRosenbrock", Method::ExponentialRosenbrock, 0.0) && ok;
+    ok = rejects("Automatic", Method::Automatic, 0.0) && ok;
+    return ok ? 0 : 1;
+}
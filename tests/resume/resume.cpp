@@ -0,0 +1,78 @@
+// Проверка продолжения после терминального события: решение, остановленное событием и продолженное
+// resume() из контрольной точки, должно совпадать с решением без остановки в пределах допуска.
+// Для BDF контрольная точка содержит историю разностей, которая должна относиться к моменту события.
+
+#include "StiffOdeSolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+using namespace StiffOde;
+
+// Осциллятор Ван дер Поля с mu = 10: жёсткий и нелинейный, BDF успевает поднять порядок до события
+void vanDerPol(double, const double* y, double* dydt)
+{
+    const double mu = 10.0;
+    dydt[0] = y[1];
+    dydt[1] = mu * (1.0 - y[0] * y[0]) * y[1] - y[0];
+}
+
+bool check(const char* name, Method method, double stepSize)
+{
+    const double eventTime = 3.3;
+    const double endTime = 8.0;
+    const std::vector<double> initialConditions { 2.0, 0.0 };
+
+    SolverOptions options;
+    options.method = method;
+    options.stepSize = stepSize;
+    options.relTolerance = 1e-8;
+    options.absTolerance = 1e-10;
+
+    StiffOdeSolver solver;
+    solver.setInPlaceSystem(vanDerPol);
+    solver.setOptions(options);
+
+    Trajectory uninterrupted;
+    const SolveResult reference = solver.solve(initialConditions, 0.0, endTime, uninterrupted);
+
+    Event event;
+    event.function = [eventTime](double t, const double*) { return t - eventTime; };
+    event.terminal = true;
+    solver.setEvents({ event });
+    Trajectory interrupted;
+    const SolveResult stopped = solver.solve(initialConditions, 0.0, endTime, interrupted);
+    const SolverCheckpoint checkpoint = solver.checkpoint();
+
+    solver.setEvents({});
+    const SolveResult resumed = solver.resume(checkpoint, endTime, interrupted);
+
+    // Погрешность обоих решений порядка допуска, умноженного на рост возмущений вдоль траектории
+    double difference = 0.0;
+    for (size_t j = 0; j < initialConditions.size(); ++j) {
+        difference = std::max(difference, std::abs(interrupted.value(j, interrupted.size() - 1)
+                                                   - uninterrupted.value(j, uninterrupted.size() - 1)));
+    }
+
+    const bool ok = reference.status == SolveStatus::Finished && stopped.status == SolveStatus::TerminalEvent
+                    && std::abs(stopped.stopTime - eventTime) < 1e-9 && checkpoint.t == stopped.stopTime
+                    && resumed.status == SolveStatus::Finished && interrupted.time(interrupted.size() - 1) == endTime
+                    && difference < 1e-5;
+    std::printf("%-14s %s: event at %.12g, difference at the end %.3g\n", name, ok ? "ok  " : "FAIL",
+                stopped.stopTime, difference);
+    return ok;
+}
+}
+
+int main()
+{
+    bool ok = true;
+    ok = check("BackwardEuler", Method::BackwardEuler, 1e-3) && ok;
+    ok = check("TrBdf2", Method::TrBdf2, 0.0) && ok;
+    ok = check("Bdf", Method::Bdf, 0.0) && ok;
+    return ok ? 0 : 1;
+}
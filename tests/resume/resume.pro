@@ -0,0 +1,13 @@
+# Тест продолжения решения после терминального события; запускается через "make check"
+TEMPLATE = app
+TARGET = resume
+QT -= core gui
+CONFIG += console c++17 testcase
+CONFIG -= app_bundle qt
+
+INCLUDEPATH += C:\Qt\eigen-3.4.0
+
+include(../../stiff_ode_core.pri)
+
+SOURCES += \
+    resume.cpp